@@ -0,0 +1,103 @@
+//
+// Colliders baked from finished hulls, so expensive collider trees can be replaced by a single polytope.
+//
+
+#include <algorithm>
+
+#include "bakedHull3D.h"
+#include "gaussMap3D.h"
+#include "quickHull3D.h"
+#include "hullCache3D.h"
+
+using namespace std;
+using namespace glm;
+
+// Edge indices are 16 bits and every triangle takes four of them, and each step adds two triangles.
+static const size_t kMaxProbedTriangles = 65536 / 4 - 2;
+
+bool BakedHullCollider3D::bake(const SurfaceState &state) {
+    // The probed mesh is only convex up to rounding, which could strand the climb, so its points are hulled again.
+    PolytopeHull3D hull;
+    if (!quickHull(state.points, &hull)) return false;
+    if (!bake(hull)) return false;
+    sphereMargin = state.splitMargin ? state.margin : 0;
+    epsilon = state.epsilon;
+    return true;
+}
+
+bool BakedHullCollider3D::bake(const PolytopeHull3D &hull) {
+    if (hull.points.empty()) return false;
+    vertices = hull.points;
+    sphereMargin = 0;
+    epsilon = 0;
+
+    vector<vector<uint32_t>> adjacent(vertices.size());
+    for (const vector<uint32_t> &face : hull.faces) {
+        for (size_t c = 0; c < face.size(); c++) {
+            uint32_t from = face[c], to = face[(c + 1) % face.size()];
+            adjacent[from].push_back(to);
+            adjacent[to].push_back(from);
+        }
+    }
+    neighborStart.assign(1, 0);
+    neighbors.clear();
+    for (vector<uint32_t> &list : adjacent) {
+        sort(list.begin(), list.end());
+        list.erase(unique(list.begin(), list.end()), list.end());
+        neighbors.insert(neighbors.end(), list.begin(), list.end());
+        neighborStart.push_back(uint32_t(neighbors.size()));
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+        uint32_t &high = seeds[axis * 2], &low = seeds[axis * 2 + 1];
+        high = low = 0;
+        for (uint32_t c = 1; c < vertices.size(); c++) {
+            if (vertices[c][axis] > vertices[high][axis]) high = c;
+            if (vertices[c][axis] < vertices[low][axis]) low = c;
+        }
+    }
+    return true;
+}
+
+size_t BakedHullCollider3D::findSupportIndex(vec3 direction) const {
+    uint32_t best = seeds[0];
+    float bestDot = dot(vertices[best], direction);
+    for (int c = 1; c < 6; c++) {
+        float d = dot(vertices[seeds[c]], direction);
+        if (d > bestDot) {
+            bestDot = d;
+            best = seeds[c];
+        }
+    }
+
+    bool climbed = true;
+    while (climbed) {
+        climbed = false;
+        for (uint32_t c = neighborStart[best], end = neighborStart[best + 1]; c < end; c++) {
+            float d = dot(vertices[neighbors[c]], direction);
+            if (d > bestDot) {
+                bestDot = d;
+                best = neighbors[c];
+                climbed = true;
+            }
+        }
+    }
+    return best;
+}
+
+bool finishHull(SurfaceState *state) {
+    HullCacheKey key = hullCacheKey(*state);
+    if (loadCachedHull(state, key)) return true;
+
+    state->points.clear();
+    state->triangles.clear();
+    if (!state->exact || !buildExactHull(state)) {
+        state->init();
+        while (!state->done()) {
+            if (state->triangles.size() > kMaxProbedTriangles) return false;
+            state->step();
+        }
+    }
+    storeCachedHull(*state, key);
+    return true;
+}
@@ -0,0 +1,42 @@
+//
+// Colliders baked from finished hulls, so expensive collider trees can be replaced by a single polytope.
+//
+
+#ifndef MINKOWSKIHULL3D_BAKEDHULL3D_H
+#define MINKOWSKIHULL3D_BAKEDHULL3D_H
+
+#include "hull3D.h"
+
+// A convex polytope with vertex adjacency. Support queries start from the best of a few extreme vertices and climb
+// to better neighbors until none is better, which on a convex polytope is the support.
+// Baked from a SurfaceState, it is an inner approximation of the state's object: no face is more than epsilon inside
+// the object's surface along its normal. The margin the state factored out is kept and added back analytically.
+struct BakedHullCollider3D : public Collider3D {
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> neighborStart; // offsets of each vertex's neighbors, with one extra at the end
+    std::vector<uint32_t> neighbors;
+    uint32_t seeds[6]; // the vertices furthest along +x, -x, +y, -y, +z and -z
+    float sphereMargin = 0;
+    float epsilon = 0; // how far inside the object the faces may be, or 0 if the hull was exact
+
+    // Bakes the hull of a finished state. Returns false if the state's points are flat.
+    bool bake(const SurfaceState &state);
+    bool bake(const PolytopeHull3D &hull);
+
+    size_t findSupportIndex(glm::vec3 direction) const;
+
+    glm::vec3 findSupport(glm::vec3 direction) override {
+        glm::vec3 core = findCoreSupport(direction);
+        // A zero direction has no normal to add the margin along, and gets the core's point like any other polytope.
+        return sphereMargin != 0 && direction != glm::vec3(0) ? core + sphereMargin * glm::normalize(direction) : core;
+    }
+    float margin() override { return sphereMargin; }
+    glm::vec3 findCoreSupport(glm::vec3 direction) override { return vertices[findSupportIndex(direction)]; }
+};
+
+// Hulls state->object from scratch and runs state to completion, exactly if state->exact is set and buildExactHull can,
+// else by probing. Goes through the hull cache if state has one. Returns false if probing would outgrow SurfaceState's
+// 16 bit indices.
+bool finishHull(SurfaceState *state);
+
+#endif //MINKOWSKIHULL3D_BAKEDHULL3D_H
@@ -0,0 +1,1807 @@
+//
+// Headless benchmarks for the hull algorithms.
+// Usage: MinkowskiHull3DBench [benchmark name...]. Runs every benchmark if none are named.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+
+#include <glm/glm.hpp>
+#include "hull3D.h"
+#include "gaussMap3D.h"
+#include "quickHull3D.h"
+#include "clusteredPoints3D.h"
+#include "supportMap3D.h"
+#include "bakedHull3D.h"
+#include "hullCache3D.h"
+#include "hullFile3D.h"
+#include "workerPool.h"
+#include "configTokens.h"
+#include "mappedFile.h"
+#include "loader.h"
+#include "colliderArena.h"
+#include "gjk3D.h"
+#include "epa3D.h"
+#include "pointsFile3D.h"
+#include "timeOfImpact3D.h"
+#include "scene3D.h"
+#include "narrowphase3D.h"
+#include "contactManifold3D.h"
+#include "separationCache3D.h"
+
+using namespace std;
+using namespace glm;
+
+typedef chrono::high_resolution_clock Clock;
+
+static double millisSince(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+// Points on the surface of a sphere, so every one of them is a hull vertex.
+static void randomSphere(vector<vec3> &points, int count, unsigned seed) {
+    mt19937 rng(seed);
+    normal_distribution<float> gauss;
+    points.clear();
+    for (int c = 0; c < count; c++) {
+        points.push_back(normalize(vec3(gauss(rng), gauss(rng), gauss(rng))));
+    }
+}
+
+// Points filling a ball, like a scan of a solid, so almost all of them are interior.
+static void randomBall(vector<vec3> &points, int count, unsigned seed) {
+    mt19937 rng(seed);
+    uniform_real_distribution<float> uniform(-1, 1);
+    points.clear();
+    while (int(points.size()) < count) {
+        vec3 pt = vec3(uniform(rng), uniform(rng), uniform(rng));
+        if (dot(pt, pt) <= 1) points.push_back(pt);
+    }
+}
+
+static vector<vec3> randomDirections(int count, unsigned seed) {
+    mt19937 rng(seed);
+    normal_distribution<float> gauss;
+    vector<vec3> dirs;
+    for (int c = 0; c < count; c++) dirs.push_back(vec3(gauss(rng), gauss(rng), gauss(rng)));
+    return dirs;
+}
+
+// Average time of a support query, in microseconds.
+static double timeSupport(Collider3D &collider, const vector<vec3> &dirs) {
+    vec3 sum = vec3(0);
+    Clock::time_point start = Clock::now();
+    for (const vec3 &dir : dirs) sum += collider.findSupport(dir);
+    double micros = millisSince(start) * 1000 / dirs.size();
+    if (sum.x == 12345) printf(" "); // keep the queries from being optimized out
+    return micros;
+}
+
+// Probes the hull to completion. Returns false if it outgrew SurfaceState's 16 bit indices.
+static bool probeHull(SurfaceState &state) {
+    state.init();
+    while (!state.done()) {
+        if (state.triangles.size() >= 16000) return false;
+        state.step();
+    }
+    return true;
+}
+
+static void benchExactSum() {
+    printf("exact_sum: A - B for random points on spheres, exact Gauss map merge vs probing\n");
+    printf("%8s  %10s  %8s  %8s  %10s  %10s\n", "POINTS", "EXACT_MS", "VERTS", "FACES", "PROBE_MS", "PROBE_TRIS");
+    for (int count : {16, 64, 256, 1024, 4096}) {
+        vector<vec3> points;
+        PointHullCollider3D a, b;
+        randomSphere(points, count, 1);
+        a.setPoints(points);
+        randomSphere(points, count, 2);
+        b.setPoints(points);
+        SubCollider3D sub;
+        sub.a = &a;
+        sub.b = &b;
+
+        Clock::time_point start = Clock::now();
+        PolytopeHull3D hull;
+        bool exact = buildExactHull(&sub, false, &hull);
+        double exactTime = millisSince(start);
+
+        SurfaceState state;
+        state.object = &sub;
+        state.epsilon = 1e-5f;
+        start = Clock::now();
+        bool probed = probeHull(state);
+        double probeTime = millisSince(start);
+
+        printf("%8d  %10.2f  %8d  %8d  ", count, exactTime,
+               exact ? int(hull.points.size()) : -1, exact ? int(hull.faces.size()) : -1);
+        if (probed) printf("%10.2f  %10d\n", probeTime, int(state.triangles.size()));
+        else printf("%10s  %10s\n", "overflow", "-");
+    }
+    printf("\n");
+}
+
+static void benchPointsReduction() {
+    printf("points_reduction: hulling a filled ball at load time, and the support queries after\n");
+    printf("%9s  %9s  %9s  %11s  %11s  %11s\n", "POINTS", "HULL", "SERIAL_MS", "PARALLEL_MS", "BEFORE_US", "AFTER_US");
+    vector<vec3> dirs = randomDirections(256, 3);
+    for (int count : {10000, 100000, 1000000}) {
+        vector<vec3> points;
+        randomBall(points, count, 4);
+
+        Clock::time_point start = Clock::now();
+        PolytopeHull3D serial;
+        quickHull(points, &serial);
+        double serialTime = millisSince(start);
+
+        start = Clock::now();
+        PolytopeHull3D parallel;
+        parallelQuickHull(points, &parallel);
+        double parallelTime = millisSince(start);
+
+        PointHullCollider3D collider;
+        collider.setPoints(points);
+        double before = timeSupport(collider, dirs);
+        collider.setPoints(parallel.points);
+        double after = timeSupport(collider, dirs);
+
+        printf("%9d  %9d  %9.2f  %11.2f  %11.3f  %11.3f\n", count, int(collider.count),
+               serialTime, parallelTime, before, after);
+    }
+    printf("\n");
+}
+
+static void benchSupportScan() {
+    printf("support_scan: microseconds per support query on unreduced clouds, by kernel\n");
+    printf("%9s", "POINTS");
+    for (int k = 0; k < NUM_SCAN_KERNELS; k++) printf("  %9s", scanKernelName(ScanKernel(k)));
+    printf("  %s\n", "MISMATCHES");
+
+    vector<vec3> dirs = randomDirections(256, 5);
+    for (int count : {1000, 100000, 1000000, -100000}) {
+        // The negative size is a coarse grid, full of exact ties, to check that every kernel breaks them the same way.
+        vector<vec3> points;
+        if (count > 0) {
+            randomSphere(points, count, 6);
+        } else {
+            mt19937 rng(7);
+            uniform_int_distribution<int> cell(-2, 2);
+            for (int c = 0; c < -count; c++) points.push_back(vec3(cell(rng), cell(rng), cell(rng)));
+        }
+        PointHullCollider3D collider;
+        collider.setPoints(points);
+        size_t padded = collider.xs.size();
+
+        int mismatches = 0;
+        printf("%9d", count);
+        for (int k = 0; k < NUM_SCAN_KERNELS; k++) {
+            ScanKernel kernel = ScanKernel(k);
+            if (!scanKernelSupported(kernel)) {
+                printf("  %9s", "-");
+                continue;
+            }
+            size_t sum = 0;
+            Clock::time_point start = Clock::now();
+            for (const vec3 &dir : dirs) {
+                sum += supportScan(collider.xs.data(), collider.ys.data(), collider.zs.data(), padded, dir, kernel);
+            }
+            printf("  %9.3f", millisSince(start) * 1000 / dirs.size());
+            for (const vec3 &dir : dirs) {
+                size_t scalar = supportScan(collider.xs.data(), collider.ys.data(), collider.zs.data(), padded, dir,
+                                            SCAN_SCALAR);
+                if (supportScan(collider.xs.data(), collider.ys.data(), collider.zs.data(), padded, dir, kernel) != scalar) {
+                    mismatches++;
+                }
+            }
+            if (sum == 1) printf(" ");
+        }
+        printf("  %d\n", mismatches);
+    }
+    printf("\n");
+}
+
+static void benchParallelScan() {
+    printf("parallel_scan: microseconds per support query on 8M unreduced points, by thread count\n");
+    printf("%7s  %9s  %10s\n", "THREADS", "QUERY_US", "MISMATCHES");
+    vector<vec3> points;
+    randomSphere(points, 8 << 20, 8);
+    PointHullCollider3D collider;
+    collider.setPoints(points);
+    vector<vec3>().swap(points);
+    vector<vec3> dirs = randomDirections(64, 9);
+    const float *xs = collider.xs.data(), *ys = collider.ys.data(), *zs = collider.zs.data();
+    size_t padded = collider.xs.size();
+
+    unsigned cores = std::max(1u, thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= std::max(cores, 4u); threads *= 2) {
+        WorkerPool pool(threads - 1);
+        size_t sum = 0;
+        Clock::time_point start = Clock::now();
+        for (const vec3 &dir : dirs) sum += parallelSupportScan(xs, ys, zs, padded, dir, pool);
+        double micros = millisSince(start) * 1000 / dirs.size();
+
+        int mismatches = 0;
+        for (const vec3 &dir : dirs) {
+            if (parallelSupportScan(xs, ys, zs, padded, dir, pool) != supportScan(xs, ys, zs, padded, dir)) mismatches++;
+        }
+        printf("%7u  %9.1f  %10d\n", threads, micros, mismatches);
+        if (sum == 1) printf(" ");
+    }
+    printf("\n");
+}
+
+static void benchClusteredScan() {
+    printf("clustered_scan: microseconds per support query on points that are all hull vertices, linear vs clustered\n");
+    printf("%9s  %9s  %9s  %12s  %9s  %9s  %10s\n",
+           "POINTS", "SCALAR_US", "SIMD_US", "CLUSTERED_US", "BUILD_MS", "VISITED", "MISMATCHES");
+    vector<vec3> dirs = randomDirections(1024, 11);
+    // Axis directions on a lattice tie between many points, which checks that the lowest index still wins.
+    for (vec3 axis : {vec3(1, 0, 0), vec3(0, -1, 0), vec3(0, 0, 1), vec3(1, 1, 0), vec3(-1, 1, 1)}) dirs.push_back(axis);
+
+    for (int count : {4096, 65536, 1 << 20, -1}) {
+        vector<vec3> points;
+        if (count > 0) {
+            randomSphere(points, count, 10);
+        } else {
+            // The surface of a 64^3 lattice cube.
+            for (int x = 0; x < 64; x++) for (int y = 0; y < 64; y++) for (int z = 0; z < 64; z++) {
+                if (x % 63 == 0 || y % 63 == 0 || z % 63 == 0) points.push_back(vec3(x, y, z) - vec3(31.5f));
+            }
+        }
+        PointHullCollider3D linear;
+        linear.setPoints(points);
+        Clock::time_point start = Clock::now();
+        ClusteredPointsCollider3D clustered;
+        clustered.setPoints(points);
+        double buildMillis = millisSince(start);
+
+        const float *xs = linear.xs.data(), *ys = linear.ys.data(), *zs = linear.zs.data();
+        size_t padded = linear.xs.size();
+        size_t sum = 0;
+        start = Clock::now();
+        for (const vec3 &dir : dirs) sum += supportScan(xs, ys, zs, padded, dir, SCAN_SCALAR);
+        double scalarMicros = millisSince(start) * 1000 / dirs.size();
+
+        double simdMicros = timeSupport(linear, dirs);
+        double clusteredMicros = timeSupport(clustered, dirs);
+
+        size_t visited = 0;
+        int mismatches = 0;
+        for (const vec3 &dir : dirs) {
+            if (clustered.findSupportIndex(dir, &visited) != linear.findSupportIndex(dir)) mismatches++;
+        }
+        // Directions that aren't finite must agree too. They scan every leaf, so they stay out of the visit counts.
+        float inf = numeric_limits<float>::infinity(), nan = numeric_limits<float>::quiet_NaN();
+        for (vec3 dir : {vec3(nan), vec3(1, nan, 0), vec3(inf, 1, 0), vec3(-inf, inf, 1)}) {
+            if (clustered.findSupportIndex(dir) != linear.findSupportIndex(dir)) mismatches++;
+        }
+        printf("%9d  %9.1f  %9.1f  %12.2f  %9.1f  %8.2f%%  %10d\n", int(points.size()), scalarMicros, simdMicros,
+               clusteredMicros, buildMillis, 100.0 * visited / (double(dirs.size()) * points.size()), mismatches);
+        if (sum == 1) printf(" ");
+    }
+    printf("\n");
+}
+
+static void benchSupportMap() {
+    printf("support_map: microseconds per support query on hull vertices, linear scan vs cube map, by resolution\n");
+    printf("%9s  %5s  %9s  %9s  %10s  %9s  %10s  %10s\n",
+           "POINTS", "RES", "SCAN_US", "MAP_US", "CANDIDATES", "MAP_KB", "BUILD_MS", "MISMATCHES");
+    vector<vec3> dirs = randomDirections(1 << 14, 12);
+    // Directions along the axes and cube edges sit on cell and face boundaries, and tie on lattices.
+    for (int x = -1; x <= 1; x++) for (int y = -1; y <= 1; y++) for (int z = -1; z <= 1; z++) {
+        if (x || y || z) dirs.push_back(vec3(x, y, z));
+    }
+
+    for (int count : {256, 4096, 16384, -1}) {
+        vector<vec3> points;
+        if (count > 0) {
+            randomSphere(points, count, 13);
+        } else {
+            // The surface of a 16^3 lattice cube, which has many ties.
+            for (int x = 0; x < 16; x++) for (int y = 0; y < 16; y++) for (int z = 0; z < 16; z++) {
+                if (x % 15 == 0 || y % 15 == 0 || z % 15 == 0) points.push_back(vec3(x, y, z) - vec3(7.5f, 7, 7));
+            }
+        }
+        PointHullCollider3D linear;
+        linear.setPoints(points);
+        double scanMicros = timeSupport(linear, dirs);
+
+        for (int res : {4, 16, 64}) {
+            MappedPointsCollider3D mapped;
+            mapped.setPoints(points);
+            Clock::time_point start = Clock::now();
+            mapped.buildMap(res);
+            double buildMillis = millisSince(start);
+            double mapMicros = timeSupport(mapped, dirs);
+
+            int mismatches = 0;
+            for (const vec3 &dir : dirs) {
+                if (mapped.findSupportIndex(dir) != linear.findSupportIndex(dir)) mismatches++;
+            }
+            printf("%9d  %5d  %9.2f  %9.3f  %10.1f  %9.1f  %10.1f  %10d\n", int(points.size()), res, scanMicros,
+                   mapMicros, double(mapped.candidates.size()) / (mapped.cellStart.size() - 1),
+                   mapped.mapBytes() / 1024.0, buildMillis, mismatches);
+        }
+    }
+    printf("\n");
+}
+
+// Counts the queries that reach a collider.
+struct CountingCollider3D : public Collider3D {
+    Collider3D *inner;
+    size_t queries = 0;
+
+    glm::vec3 findSupport(glm::vec3 direction) override {
+        queries++;
+        return inner->findSupport(direction);
+    }
+};
+
+static void benchSharedSymbols() {
+    printf("shared_symbols: a DAG that reaches one points collider along 8 paths, as a tree vs memoized\n");
+    printf("%9s  %9s  %9s  %11s  %11s  %10s\n",
+           "POINTS", "TREE_US", "SHARED_US", "TREE_EVALS", "SHARED_EVALS", "MISMATCHES");
+    vector<vec3> dirs = randomDirections(4096, 14);
+    for (int count : {64, 4096, 65536}) {
+        vector<vec3> points;
+        randomSphere(points, count, 15);
+        PointHullCollider3D hull;
+        hull.setPoints(points);
+        CountingCollider3D counted;
+        counted.inner = &hull;
+
+        // b = p + p, c = b - p, d = c + b, object = d - c
+        Collider3D *results[2];
+        double micros[2];
+        size_t evaluations[2];
+        for (int shared = 0; shared < 2; shared++) {
+            Collider3D *p = &counted;
+            if (shared) p = new SharedCollider3D(p);
+            AddCollider3D *b = new AddCollider3D();
+            b->a = p;
+            b->b = p;
+            Collider3D *sharedB = shared ? new SharedCollider3D(b) : (Collider3D *) b;
+            SubCollider3D *c = new SubCollider3D();
+            c->a = sharedB;
+            c->b = p;
+            Collider3D *sharedC = shared ? new SharedCollider3D(c) : (Collider3D *) c;
+            AddCollider3D *d = new AddCollider3D();
+            d->a = sharedC;
+            d->b = sharedB;
+            SubCollider3D *object = new SubCollider3D();
+            object->a = d;
+            object->b = sharedC;
+            results[shared] = object;
+
+            counted.queries = 0;
+            micros[shared] = timeSupport(*object, dirs);
+            evaluations[shared] = counted.queries;
+        }
+
+        int mismatches = 0;
+        for (const vec3 &dir : dirs) {
+            if (results[0]->findSupport(dir) != results[1]->findSupport(dir)) mismatches++;
+        }
+        printf("%9d  %9.2f  %9.2f  %11.1f  %11.1f  %10d\n", count, micros[0], micros[1],
+               double(evaluations[0]) / dirs.size(), double(evaluations[1]) / dirs.size(), mismatches);
+    }
+    printf("\n");
+}
+
+static void benchBake() {
+    printf("bake: a sum of 6 clouds of 1024 points and a sphere, queried as a tree vs baked\n");
+    printf("%8s  %9s  %9s  %9s  %9s  %9s  %11s\n",
+           "EPSILON", "BAKE_MS", "VERTICES", "TREE_US", "BAKED_US", "MAX_ERROR", "MIN_ERROR");
+    vector<vec3> dirs = randomDirections(4096, 16);
+
+    vector<PointHullCollider3D> clouds(6);
+    Collider3D *tree = nullptr;
+    for (int c = 0; c < 6; c++) {
+        vector<vec3> points;
+        randomSphere(points, 1024, 17 + c);
+        for (vec3 &pt : points) pt *= 0.2f;
+        clouds[c].setPoints(points);
+        if (!tree) {
+            tree = &clouds[c];
+            continue;
+        }
+        AddCollider3D *add = new AddCollider3D();
+        add->a = tree;
+        add->b = &clouds[c];
+        tree = add;
+    }
+    SphereCollider3D sphere;
+    sphere.radius = 0.1f;
+    AddCollider3D object;
+    object.a = tree;
+    object.b = &sphere;
+
+    // The exact sum has too many faces to index, so these are all probed.
+    for (float epsilon : {0.01f, 0.003f, 0.001f}) {
+        Clock::time_point start = Clock::now();
+        SurfaceState state;
+        state.object = &object;
+        state.epsilon = epsilon;
+        state.splitMargin = true;
+        BakedHullCollider3D baked;
+        if (!finishHull(&state) || !baked.bake(state)) {
+            printf("%8g  failed\n", epsilon);
+            continue;
+        }
+        double bakeMillis = millisSince(start);
+
+        // How far the baked surface is inside the tree's, per unit direction. It should be between 0 and epsilon.
+        float maxError = 0, minError = 0;
+        for (const vec3 &dir : dirs) {
+            vec3 unit = normalize(dir);
+            float error = dot(object.findSupport(unit), unit) - dot(baked.findSupport(unit), unit);
+            maxError = std::max(maxError, error);
+            minError = std::min(minError, error);
+        }
+        printf("%8g  %9.1f  %9d  %9.2f  %9.3f  %9.2e  %11.2e\n", epsilon, bakeMillis, int(baked.vertices.size()),
+               timeSupport(object, dirs), timeSupport(baked, dirs), maxError, minError);
+    }
+    printf("\n");
+}
+
+static void benchHullCache() {
+    printf("hull_cache: building a probed hull cold vs loading it from the cache, in bench_hull_cache/\n");
+    printf("%8s  %9s  %9s  %9s  %9s  %9s  %9s\n",
+           "EPSILON", "TRIANGLES", "COLD_MS", "WARM_MS", "HASH_MS", "FILE_KB", "IDENTICAL");
+    vector<PointHullCollider3D> clouds(3);
+    AddCollider3D sum;
+    SubCollider3D object;
+    for (int c = 0; c < 3; c++) {
+        vector<vec3> points;
+        randomSphere(points, 2048, 30 + c);
+        clouds[c].setPoints(points);
+    }
+    sum.a = &clouds[0];
+    sum.b = &clouds[1];
+    object.a = &sum;
+    object.b = &clouds[2];
+
+    const char *directory = "bench_hull_cache";
+    for (float epsilon : {0.01f, 0.003f}) {
+        SurfaceState cold;
+        cold.object = &object;
+        cold.epsilon = epsilon;
+        cold.cacheDirectory = directory;
+        Clock::time_point start = Clock::now();
+        finishHull(&cold);
+        double coldMillis = millisSince(start);
+
+        SurfaceState warm;
+        warm.object = &object;
+        warm.epsilon = epsilon;
+        warm.cacheDirectory = directory;
+        start = Clock::now();
+        HullCacheKey key = hullCacheKey(warm);
+        double hashMillis = millisSince(start);
+        bool loaded = loadCachedHull(&warm, key);
+        double warmMillis = millisSince(start);
+
+        bool identical = loaded && warm.points == cold.points && warm.triangles.size() == cold.triangles.size() &&
+                         memcmp(warm.triangles.data(), cold.triangles.data(),
+                                cold.triangles.size() * sizeof(Triangle)) == 0;
+        size_t fileBytes = sizeof(HullFileHeader) + cold.points.size() * sizeof(vec3) +
+                           cold.triangles.size() * sizeof(Triangle) + key.description.size();
+        printf("%8g  %9d  %9.1f  %9.2f  %9.2f  %9.1f  %9s\n", epsilon, int(cold.triangles.size()), coldMillis,
+               warmMillis, hashMillis, fileBytes / 1024.0, identical ? "yes" : "NO");
+    }
+
+    // With no room at all, storing evicts everything but the hull just stored, which is then removed by hand.
+    SurfaceState small;
+    small.object = &object;
+    small.epsilon = 0.02f;
+    small.cacheDirectory = directory;
+    small.cacheBytes = 1;
+    finishHull(&small);
+    SurfaceState older;
+    older.object = &object;
+    older.epsilon = 0.01f;
+    older.cacheDirectory = directory;
+    SurfaceState newest;
+    newest.object = &object;
+    newest.epsilon = small.epsilon;
+    newest.cacheDirectory = directory;
+    HullCacheKey newestKey = hullCacheKey(newest);
+    printf("after storing with a 1 byte limit, the older hull is %s and the new one is %s\n",
+           loadCachedHull(&older, hullCacheKey(older)) ? "STILL CACHED" : "evicted",
+           loadCachedHull(&newest, newestKey) ? "kept" : "GONE");
+    char newestPath[64];
+    snprintf(newestPath, sizeof(newestPath), "%s/%016llx.hull", directory, (unsigned long long) newestKey.hash);
+    remove(newestPath);
+    remove(directory);
+    printf("\n");
+}
+
+static void benchHullFile() {
+    printf("hull_file: writing a probed hull with planes and adjacency, then mapping it vs copying it back\n");
+    printf("%9s  %9s  %9s  %9s  %9s  %9s  %9s\n",
+           "TRIANGLES", "FILE_KB", "WRITE_MS", "OPEN_US", "COPY_US", "PLANE_US", "IDENTICAL");
+    vector<vec3> points;
+    randomSphere(points, 4096, 40);
+    PointHullCollider3D cloud;
+    cloud.setPoints(points);
+    SphereCollider3D sphere;
+    sphere.radius = 0.2f;
+    AddCollider3D object;
+    object.a = &cloud;
+    object.b = &sphere;
+
+    const char *path = "bench_hull_file.hull";
+    for (float epsilon : {0.01f, 0.002f}) {
+        SurfaceState state;
+        state.object = &object;
+        state.epsilon = epsilon;
+        if (!probeHull(state)) continue;
+
+        Clock::time_point start = Clock::now();
+        writeHullFile(path, state, HULL_FILE_PLANES | HULL_FILE_ADJACENCY);
+        double writeMillis = millisSince(start);
+
+        // Opening only maps the file and reads its header.
+        start = Clock::now();
+        HullFile file;
+        bool opened = file.open(path);
+        double openMicros = millisSince(start) * 1000;
+
+        start = Clock::now();
+        SurfaceState copy;
+        if (opened) file.copyTo(&copy);
+        double copyMicros = millisSince(start) * 1000;
+
+        // Using a section in place: the furthest plane from the origin.
+        start = Clock::now();
+        float furthest = 0;
+        for (uint32_t c = 0; opened && c < file.header->triangleCount; c++) {
+            furthest = std::max(furthest, file.planes()[c].w);
+        }
+        double planeMicros = millisSince(start) * 1000;
+
+        bool identical = opened && copy.points == state.points && copy.triangles.size() == state.triangles.size() &&
+                         memcmp(copy.triangles.data(), state.triangles.data(),
+                                state.triangles.size() * sizeof(Triangle)) == 0 && furthest > 0;
+        printf("%9d  %9.1f  %9.2f  %9.1f  %9.1f  %9.1f  %9s\n", int(state.triangles.size()),
+               opened ? (file.header->neighbors + file.header->neighborCount * 4) / 1024.0 : 0.0, writeMillis, openMicros, copyMicros, planeMicros,
+               identical ? "yes" : "NO");
+    }
+    remove(path);
+    printf("\n");
+}
+
+// Keeps every face it is given, with when it got it.
+struct RecordingSink : public FaceSink {
+    struct Face {
+        uint16_t triangle;
+        vec3 a, b, c;
+        double millis;
+    };
+    vector<Face> faces;
+    vector<Face> live; // by triangle, the faces emitted and not retracted, with triangle 65535 for none
+    Clock::time_point start;
+
+    void face(uint16_t triangle, vec3 a, vec3 b, vec3 c) override {
+        faces.push_back({triangle, a, b, c, millisSince(start)});
+        if (live.size() <= triangle) live.resize(triangle + 1, Face{65535, vec3(0), vec3(0), vec3(0), 0});
+        live[triangle] = faces.back();
+    }
+
+    void retract(uint16_t triangle) override {
+        live[triangle].triangle = 65535;
+    }
+};
+
+// The triangles of the mesh the sink doesn't hold exactly, plus the faces it holds that aren't in the mesh.
+static int liveMismatches(const SurfaceState &state, const RecordingSink &sink) {
+    int mismatches = 0;
+    for (size_t t = 0; t < std::max(state.triangles.size(), sink.live.size()); t++) {
+        bool held = t < sink.live.size() && sink.live[t].triangle == t;
+        if (t >= state.triangles.size()) {
+            mismatches += held;
+            continue;
+        }
+        const Triangle &tri = state.triangles[t];
+        vec3 a = state.points[tri.edges[0].vertex], b = state.points[tri.edges[1].vertex];
+        vec3 c = state.points[tri.edges[2].vertex];
+        if (cross(c - b, a - b) == vec3(0)) {
+            mismatches += held; // degenerate triangles aren't emitted
+        } else if (!held || sink.live[t].a != a || sink.live[t].b != b || sink.live[t].c != c) {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static bool sameMesh(const SurfaceState &a, const SurfaceState &b) {
+    bool same = a.points == b.points && a.triangles.size() == b.triangles.size();
+    for (size_t t = 0; same && t < a.triangles.size(); t++) {
+        same = memcmp(a.triangles[t].edges, b.triangles[t].edges, sizeof(Triangle::edges)) == 0;
+    }
+    return same;
+}
+
+static void benchStreaming() {
+    printf("streaming: probing a rounded cloud with and without streaming faces as they settle\n");
+    printf("%8s  %6s  %9s  %9s  %9s  %9s  %9s  %10s  %9s\n",
+           "EPSILON", "MODE", "TRIANGLES", "BUILD_MS", "FIRST_MS", "HALF_MS", "RETRACTED", "MISMATCHES", "SAME_MESH");
+    vector<vec3> points;
+    randomSphere(points, 256, 50);
+    PointHullCollider3D cloud;
+    cloud.setPoints(points);
+    SphereCollider3D sphere;
+    sphere.radius = 0.3f;
+    AddCollider3D object;
+    object.a = &cloud;
+    object.b = &sphere;
+
+    for (float epsilon : {0.01f, 0.002f}) {
+        SurfaceState batch;
+        for (int streaming = 0; streaming < 2; streaming++) {
+            SurfaceState state;
+            state.object = &object;
+            state.epsilon = epsilon;
+            RecordingSink sink;
+            if (streaming) state.sink = &sink;
+            sink.start = Clock::now();
+            if (!probeHull(state)) continue;
+            double buildMillis = millisSince(sink.start);
+            if (!streaming) batch = state;
+
+            double firstMillis = sink.faces.empty() ? 0 : sink.faces[0].millis;
+            double halfMillis = sink.faces.empty() ? 0 : sink.faces[sink.faces.size() / 2].millis;
+            printf("%8g  %6s  %9d  %9.2f  %9.2f  %9.2f  %9d  %10d  %9s\n", epsilon, streaming ? "stream" : "batch",
+                   int(state.triangles.size()), buildMillis, firstMillis, halfMillis, int(state.retractedFaces),
+                   streaming ? liveMismatches(state, sink) : 0, sameMesh(state, batch) ? "yes" : "NO");
+        }
+    }
+
+    // Flips rarely reach settled faces. Flat ellipsoids make them often enough to check the retractions.
+    int clouds = 128, same = 0, mismatched = 0;
+    size_t retracted = 0;
+    for (int seed = 0; seed < clouds; seed++) {
+        randomSphere(points, 500, unsigned(seed));
+        for (vec3 &pt : points) pt *= vec3(1, 0.2f, 3);
+        cloud.setPoints(points);
+        SurfaceState batch, streamed;
+        batch.object = streamed.object = &cloud;
+        batch.epsilon = streamed.epsilon = 0.01f;
+        RecordingSink sink;
+        streamed.sink = &sink;
+        probeHull(batch);
+        probeHull(streamed);
+        same += sameMesh(batch, streamed);
+        mismatched += liveMismatches(streamed, sink) != 0;
+        retracted += streamed.retractedFaces;
+    }
+    printf("%d flat ellipsoids: %d meshes the same with and without a sink, %d streams differing from their mesh, "
+           "%d faces retracted\n", clouds, same, mismatched, int(retracted));
+    printf("\n");
+}
+
+// Writes a config with one points line of count points from a ball, in a mix of the formats people write floats in.
+static void writePointsConfig(const char *path, int count, unsigned seed) {
+    vector<vec3> points;
+    randomBall(points, count, seed);
+    FILE *file = fopen(path, "w");
+    if (!file) return;
+    fprintf(file, "# generated by the config_parse benchmark\nepsilon 0.01\nobject points");
+    for (int c = 0; c < count; c++) {
+        const vec3 &pt = points[c];
+        if (c % 16 == 0) fprintf(file, " %e %.9g %g", pt.x, pt.y, pt.z);
+        else fprintf(file, " %.7g %.7g %.7g", pt.x, pt.y, pt.z);
+    }
+    fprintf(file, "\n");
+    fclose(file);
+}
+
+// How the loader used to read configs: each line copied into a string, then into a stream.
+static void parseWithStreams(const char *path, vector<float> &values) {
+    ifstream file(path);
+    string line, token;
+    while (getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        istringstream tokens(line);
+        tokens >> token >> token;
+        float value;
+        while (tokens >> value) values.push_back(value);
+    }
+}
+
+static void parseWithTokens(const char *path, vector<float> &values) {
+    MappedFile file;
+    if (!file.open(path)) return;
+    const char *end = file.data() + file.size();
+    string token;
+    for (const char *line = file.data(), *next; line != end; line = next) {
+        const char *lineEnd = static_cast<const char *>(memchr(line, '\n', size_t(end - line)));
+        next = lineEnd ? lineEnd + 1 : end;
+        if (!lineEnd) lineEnd = end;
+        if (line == lineEnd || line[0] == '#') continue;
+        ConfigTokens tokens(line, lineEnd);
+        tokens.word(token);
+        tokens.word(token);
+        values.reserve(values.size() + tokens.countTokens());
+        float value;
+        while (tokens.number(value)) values.push_back(value);
+    }
+}
+
+static void benchConfigParse() {
+    printf("config_parse: parsing big points configs with streams vs tokens in the mapped file, then loading them\n");
+    printf("%9s  %8s  %9s  %9s  %10s  %10s  %9s  %9s\n",
+           "POINTS", "FILE_MB", "STREAM_MS", "TOKENS_MS", "STREAM_MBS", "TOKEN_MBS", "LOAD_MS", "IDENTICAL");
+    const char *path = "bench_config_parse.txt";
+    for (int count : {1 << 20, 1 << 23}) {
+        writePointsConfig(path, count, 60);
+        MappedFile mapped;
+        double megabytes = mapped.open(path) ? mapped.size() / double(1 << 20) : 0;
+        mapped.close();
+
+        vector<float> streamed, tokenized;
+        Clock::time_point start = Clock::now();
+        parseWithStreams(path, streamed);
+        double streamMillis = millisSince(start);
+        start = Clock::now();
+        parseWithTokens(path, tokenized);
+        double tokenMillis = millisSince(start);
+
+        bool identical = streamed.size() == size_t(count) * 3 && streamed.size() == tokenized.size() &&
+                         memcmp(streamed.data(), tokenized.data(), streamed.size() * sizeof(float)) == 0;
+
+        ColliderArena colliders;
+        SurfaceState state;
+        start = Clock::now();
+        load(path, &state, &colliders);
+        double loadMillis = millisSince(start);
+        printf("%9d  %8.1f  %9.1f  %9.1f  %10.1f  %10.1f  %9.1f  %9s\n", count, megabytes, streamMillis, tokenMillis,
+               megabytes / streamMillis * 1000, megabytes / tokenMillis * 1000, loadMillis, identical ? "yes" : "NO");
+    }
+    remove(path);
+
+    // Tokens at the edges of the float range, and too long for any fixed buffer, must fail or parse like in a stream.
+    vector<string> edges = {"1e39", "-1e39", "3.4028235e38", "3.4028236e38", "1.7976931348623157e308", "1e-39",
+                            "-1e-50", "1e-45", "123456789012345678901234567890", "1e", "1.", ".5", "nan", "inf",
+                            "0." + string(200, '3'), string(150, '0') + "1.5", string(60, '9') + "e-30"};
+    int agree = 0;
+    for (const string &token : edges) {
+        istringstream stream(token);
+        float streamed = 0, parsed = 0;
+        bool streamOk = bool(stream >> streamed);
+        const char *cursor = token.data();
+        bool parsedOk = parseFloat(cursor, token.data() + token.size(), &parsed);
+        if (streamOk == parsedOk && (!streamOk || memcmp(&streamed, &parsed, sizeof(float)) == 0)) agree++;
+    }
+    printf("edge case tokens parsed like streams: %d of %d\n", agree, int(edges.size()));
+    printf("\n");
+}
+
+static void benchPointsFile() {
+    printf("points_file: mapping a binary points file vs reading it into a points collider, then scanning both\n");
+    printf("%9s  %8s  %9s  %9s  %9s  %9s  %9s  %9s  %10s\n",
+           "POINTS", "FILE_MB", "WRITE_MS", "MAP_MS", "READ_MS", "FIRST_MS", "VIEW_MS", "OWNED_MS", "MISMATCHES");
+    const char *path = "bench_points_file.points";
+    vector<vec3> dirs = randomDirections(16, 71);
+    for (int count : {1 << 20, 1 << 25}) {
+        vector<vec3> points;
+        randomBall(points, count, 70);
+        Clock::time_point start = Clock::now();
+        writePointsFile(path, points);
+        double writeMillis = millisSince(start);
+        points = vector<vec3>();
+
+        start = Clock::now();
+        PointsFile file;
+        if (!file.open(path)) continue;
+        PointViewCollider3D view;
+        file.view(&view);
+        double mapMillis = millisSince(start);
+
+        // The same file read the usual way, into memory the collider owns.
+        start = Clock::now();
+        PointHullCollider3D owned;
+        FILE *in = fopen(path, "rb");
+        PointsFileHeader header;
+        owned.count = count;
+        for (vector<float> *axis : {&owned.xs, &owned.ys, &owned.zs}) axis->resize(size_t(file.header->padded));
+        bool read = in && fread(&header, sizeof(header), 1, in) == 1;
+        const uint64_t offsets[3] = {header.xs, header.ys, header.zs};
+        vector<float> *axes[3] = {&owned.xs, &owned.ys, &owned.zs};
+        for (int axis = 0; axis < 3 && read; axis++) {
+            read = fseek(in, long(offsets[axis]), SEEK_SET) == 0 &&
+                   fread(axes[axis]->data(), sizeof(float), axes[axis]->size(), in) == axes[axis]->size();
+        }
+        if (in) fclose(in);
+        double readMillis = millisSince(start);
+
+        start = Clock::now();
+        view.findSupport(dirs[0]);
+        double firstMillis = millisSince(start);
+        double viewMillis = timeSupport(view, dirs) / 1000;
+        double ownedMillis = timeSupport(owned, dirs) / 1000;
+        int mismatches = read ? 0 : int(dirs.size());
+        for (const vec3 &dir : dirs) {
+            if (read && view.findSupportIndex(dir) != owned.findSupportIndex(dir)) mismatches++;
+        }
+        printf("%9d  %8.1f  %9.1f  %9.3f  %9.1f  %9.2f  %9.2f  %9.2f  %10d\n", count,
+               (file.header->zs + file.header->padded * sizeof(float)) / double(1 << 20), writeMillis, mapMillis,
+               readMillis, firstMillis, viewMillis, ownedMillis, mismatches);
+    }
+    remove(path);
+    printf("\n");
+}
+
+// A generated assembly: a point per part, summed into a chain, so every symbol but the last is referenced once.
+static void writeAssemblyConfig(const char *path, int parts) {
+    FILE *file = fopen(path, "w");
+    if (!file) return;
+    fprintf(file, "epsilon 0.01\nsum0 point 0 0 0\n");
+    for (int c = 1; c < parts; c++) {
+        fprintf(file, "part%d point %d %d %d\n", c, c % 7, c % 11, c % 13);
+        fprintf(file, "sum%d add sum%d part%d\n", c, c - 1, c);
+    }
+    fprintf(file, "object point 0 0 0\n");
+    fclose(file);
+}
+
+static void benchSymbolTable() {
+    printf("symbol_table: loading generated assembly configs, and freeing their colliders with the arena\n");
+    printf("%9s  %9s  %9s  %12s  %9s  %9s\n", "SYMBOLS", "LOAD_MS", "US_PER", "ARENA_OBJECTS", "ARENA_KB", "FREE_MS");
+    const char *path = "bench_symbol_table.txt";
+    for (int parts : {1000, 10000, 100000}) {
+        writeAssemblyConfig(path, parts);
+        ColliderArena colliders;
+        SurfaceState state;
+        Clock::time_point start = Clock::now();
+        load(path, &state, &colliders);
+        double loadMillis = millisSince(start);
+        size_t objects = colliders.objectCount(), bytes = colliders.blockBytes();
+        start = Clock::now();
+        colliders.clear();
+        double freeMillis = millisSince(start);
+        int symbols = parts * 2;
+        printf("%9d  %9.1f  %9.3f  %12d  %9.1f  %9.2f\n", symbols, loadMillis, loadMillis * 1000 / symbols,
+               int(objects), bytes / 1024.0, freeMillis);
+    }
+    remove(path);
+    printf("\n");
+}
+
+// Loads the config the viewer ships with, from the repository root or a build directory inside it.
+static bool loadShippedConfig(SurfaceState *state, ColliderArena *arena) {
+    return load("assets/config.txt", state, arena) || load("../assets/config.txt", state, arena);
+}
+
+// The largest distance of point outside the planes of a finished state, which is at most 0 inside its hull.
+static float outsideHull(const SurfaceState &state, vec3 point) {
+    float outside = -numeric_limits<float>::infinity();
+    for (const Triangle &tri : state.triangles) {
+        vec3 a = state.points[tri.edges[0].vertex];
+        vec3 b = state.points[tri.edges[1].vertex];
+        vec3 c = state.points[tri.edges[2].vertex];
+        vec3 normal = cross(c - b, a - b);
+        if (normal != vec3(0)) outside = std::max(outside, dot(normalize(normal), point - a));
+    }
+    return outside;
+}
+
+static void benchGjkIntersect() {
+    printf("gjk_intersect: does the shipped config's object contain random points, by GJK vs building its hull\n");
+    ColliderArena colliders;
+    SurfaceState shipped;
+    if (!loadShippedConfig(&shipped, &colliders)) return;
+    printf("%8s  %8s  %8s  %8s  %8s  %9s  %9s  %8s  %9s\n",
+           "QUERIES", "INSIDE", "GJK_US", "AVG_ITER", "MAX_ITER", "AVG_CALLS", "HULL_MS", "SPEEDUP", "DISAGREE");
+
+    // Every query moves the object, which invalidates a hull but costs GJK nothing.
+    Clock::time_point start = Clock::now();
+    SurfaceState hull;
+    hull.object = shipped.object;
+    hull.epsilon = shipped.epsilon;
+    finishHull(&hull);
+    double hullMillis = millisSince(start);
+
+    mt19937 rng(80);
+    uniform_real_distribution<float> uniform(-3, 3);
+    const int queries = 100000;
+    vector<vec3> offsets;
+    for (int c = 0; c < queries; c++) offsets.push_back(vec3(uniform(rng), uniform(rng), uniform(rng)));
+
+    PointCollider3D shift;
+    AddCollider3D shifted;
+    shifted.a = shipped.object;
+    shifted.b = &shift;
+    GjkStats total;
+    int maxIterations = 0, inside = 0, disagree = 0;
+    vector<char> results(queries);
+    start = Clock::now();
+    for (int c = 0; c < queries; c++) {
+        GjkStats stats;
+        shift.point = -offsets[c];
+        results[c] = gjkContainsOrigin(&shifted, &stats);
+        total.iterations += stats.iterations;
+        total.supportCalls += stats.supportCalls;
+        maxIterations = std::max(maxIterations, stats.iterations);
+    }
+    double gjkMicros = millisSince(start) * 1000 / queries;
+
+    // The hull is within epsilon inside the object, so only points further than that from its surface must agree.
+    for (int c = 0; c < queries; c++) {
+        float outside = outsideHull(hull, offsets[c]);
+        inside += results[c];
+        if (results[c] ? outside > hull.epsilon : outside <= 0) disagree++;
+    }
+    printf("%8d  %8d  %8.2f  %8.2f  %8d  %9.2f  %9.2f  %8.0f  %9d\n", queries, inside, gjkMicros,
+           double(total.iterations) / queries, maxIterations, double(total.supportCalls) / queries, hullMillis,
+           hullMillis * 1000 / gjkMicros, disagree);
+    printf("\n");
+}
+
+static void benchEpa() {
+    printf("epa: penetration depth of random points inside the shipped config's object, by EPA vs searching its hull\n");
+    ColliderArena colliders;
+    SurfaceState shipped;
+    if (!loadShippedConfig(&shipped, &colliders)) return;
+    printf("%8s  %8s  %8s  %8s  %9s  %9s  %8s  %10s  %10s\n",
+           "EPSILON", "QUERIES", "EPA_US", "AVG_ITER", "AVG_CALLS", "HULL_MS", "SPEEDUP", "MAX_DIFF", "WITNESS_ERR");
+
+    Clock::time_point start = Clock::now();
+    SurfaceState hull;
+    hull.object = shipped.object;
+    hull.epsilon = shipped.epsilon;
+    finishHull(&hull);
+    double hullMillis = millisSince(start);
+
+    mt19937 rng(90);
+    uniform_real_distribution<float> uniform(-3, 3);
+    vector<vec3> offsets;
+    while (offsets.size() < 10000) {
+        vec3 offset = vec3(uniform(rng), uniform(rng), uniform(rng));
+        if (outsideHull(hull, offset) < 0) offsets.push_back(offset);
+    }
+
+    PointCollider3D shift;
+    AddCollider3D shifted;
+    shifted.a = shipped.object;
+    shifted.b = &shift;
+    for (float epsilon : {1e-2f, 1e-3f, 1e-4f}) {
+        long long iterations = 0, calls = 0;
+        vector<PenetrationResult> results(offsets.size());
+        start = Clock::now();
+        for (size_t c = 0; c < offsets.size(); c++) {
+            shift.point = -offsets[c];
+            epaPenetration(&shifted, nullptr, epsilon, &results[c]);
+            iterations += results[c].iterations;
+            calls += results[c].supportCalls;
+        }
+        double epaMicros = millisSince(start) * 1000 / offsets.size();
+
+        // Both are inner approximations, within their epsilon of the true depth.
+        float maxDiff = 0, witnessError = 0;
+        for (size_t c = 0; c < offsets.size(); c++) {
+            const PenetrationResult &result = results[c];
+            maxDiff = std::max(maxDiff, std::abs(result.depth + outsideHull(hull, offsets[c])));
+            witnessError = std::max(witnessError, length(result.witnessA - result.witnessB - result.depth * result.normal));
+        }
+        printf("%8g  %8d  %8.2f  %8.2f  %9.2f  %9.2f  %8.0f  %10.5f  %10.2g\n", epsilon, int(offsets.size()), epaMicros,
+               double(iterations) / offsets.size(), double(calls) / offsets.size(), hullMillis,
+               hullMillis * 1000 / epaMicros, maxDiff, witnessError);
+    }
+    printf("\n");
+}
+
+// The exact distance from the origin to the hull of points outside it, by searching the faces of the hull.
+static float hullDistance(const vector<vec3> &points) {
+    PolytopeHull3D hull;
+    if (!quickHull(points, &hull)) return -1;
+    float best = numeric_limits<float>::infinity();
+    for (const vector<uint32_t> &face : hull.faces) {
+        for (size_t c = 2; c < face.size(); c++) {
+            GjkSimplex triangle;
+            triangle.points[0] = hull.points[face[0]];
+            triangle.points[1] = hull.points[face[c - 1]];
+            triangle.points[2] = hull.points[face[c]];
+            triangle.count = 3;
+            vec3 closest;
+            gjkSolveSimplex(triangle, &closest);
+            best = std::min(best, length(closest));
+        }
+    }
+    return best;
+}
+
+static void benchGjkDistance() {
+    printf("gjk_distance: distances between separated clouds, checked against their hull, then per frame with warm starts\n");
+    mt19937 rng(100);
+    uniform_real_distribution<float> uniform(-1, 1);
+    float maxError = 0, maxWitnessError = 0;
+    int checked = 0;
+    for (int pair = 0; pair < 200; pair++) {
+        vector<vec3> pointsA, pointsB, difference;
+        randomSphere(pointsA, 64, 1000 + pair);
+        randomBall(pointsB, 64, 2000 + pair);
+        vec3 offset = 2.5f * normalize(vec3(uniform(rng), uniform(rng), uniform(rng)));
+        for (vec3 &pt : pointsA) pt += offset;
+        PointHullCollider3D a, b;
+        a.setPoints(pointsA);
+        b.setPoints(pointsB);
+        DistanceResult result;
+        if (!gjkDistance(&a, &b, &result)) continue;
+        for (const vec3 &pa : pointsA) {
+            for (const vec3 &pb : pointsB) difference.push_back(pa - pb);
+        }
+        maxError = std::max(maxError, std::abs(result.distance - hullDistance(difference)));
+        maxWitnessError = std::max(maxWitnessError, std::abs(length(result.witnessA - result.witnessB) - result.distance));
+        checked++;
+    }
+    printf("%d pairs: max distance error %.2g, max witness error %.2g\n", checked, maxError, maxWitnessError);
+
+    // Pairs of rounded clouds drifting past each other, queried every frame.
+    printf("%6s  %6s  %7s  %9s  %9s  %9s  %10s\n", "PAIRS", "FRAMES", "START", "QUERY_US", "AVG_ITER", "AVG_CALLS",
+           "MAX_DIFF");
+    const int pairs = 1000, frames = 60;
+    vector<PointHullCollider3D> clouds(pairs);
+    vector<SphereCollider3D> spheres(pairs);
+    vector<AddCollider3D> rounded(pairs);
+    vector<PointCollider3D> positions(pairs);
+    vector<AddCollider3D> moved(pairs);
+    vector<vec3> starts(pairs), velocities(pairs);
+    for (int c = 0; c < pairs; c++) {
+        vector<vec3> points;
+        randomSphere(points, 128, 3000 + c);
+        clouds[c].setPoints(points);
+        spheres[c].radius = 0.1f;
+        rounded[c].a = &clouds[c];
+        rounded[c].b = &spheres[c];
+        moved[c].a = &rounded[c];
+        moved[c].b = &positions[c];
+        starts[c] = 3.0f * normalize(vec3(uniform(rng), uniform(rng), uniform(rng)));
+        velocities[c] = 0.01f * vec3(uniform(rng), uniform(rng), uniform(rng));
+    }
+    vector<float> coldDistances;
+    for (int warm = 0; warm < 2; warm++) {
+        vector<GjkSimplex> simplices(pairs);
+        long long iterations = 0, calls = 0, queries = 0;
+        float maxDiff = 0;
+        Clock::time_point start = Clock::now();
+        for (int frame = 0; frame < frames; frame++) {
+            for (int c = 0; c < pairs; c++) {
+                positions[c].point = starts[c] + float(frame) * velocities[c];
+                DistanceResult result;
+                gjkDistance(&moved[c], &rounded[(c + 1) % pairs], &result, warm ? &simplices[c] : nullptr);
+                iterations += result.iterations;
+                calls += result.supportCalls;
+                if (!warm) coldDistances.push_back(result.distance);
+                else maxDiff = std::max(maxDiff, std::abs(result.distance - coldDistances[queries]));
+                queries++;
+            }
+        }
+        double micros = millisSince(start) * 1000 / queries;
+        printf("%6d  %6d  %7s  %9.2f  %9.2f  %9.2f  %10.2g\n", pairs, frames, warm ? "warm" : "cold", micros,
+               double(iterations) / queries, double(calls) / queries, maxDiff);
+    }
+    printf("\n");
+}
+
+// Where the ray from origin along translation enters a finished state's hull, as a fraction, by clipping it against
+// every face plane. Returns false if it misses.
+static bool hullRaycast(const SurfaceState &state, vec3 origin, vec3 translation, float *fraction) {
+    float enter = 0, exit = 1;
+    for (const Triangle &tri : state.triangles) {
+        vec3 a = state.points[tri.edges[0].vertex];
+        vec3 b = state.points[tri.edges[1].vertex];
+        vec3 c = state.points[tri.edges[2].vertex];
+        vec3 normal = cross(c - b, a - b);
+        if (normal == vec3(0)) continue;
+        float outside = dot(normal, origin - a), along = dot(normal, translation);
+        if (along == 0) {
+            if (outside > 0) return false;
+        } else if (along < 0) {
+            enter = std::max(enter, -outside / along);
+        } else {
+            exit = std::min(exit, -outside / along);
+        }
+    }
+    *fraction = enter;
+    return enter <= exit;
+}
+
+static void benchRaycast() {
+    printf("raycast: rays and casts against the shipped config's object, by GJK vs clipping against its hull\n");
+    ColliderArena colliders;
+    SurfaceState shipped;
+    if (!loadShippedConfig(&shipped, &colliders)) return;
+
+    Clock::time_point start = Clock::now();
+    SurfaceState hull;
+    hull.object = shipped.object;
+    hull.epsilon = shipped.epsilon;
+    finishHull(&hull);
+    double hullMillis = millisSince(start);
+
+    // Rays from a shell around the object towards random points near its middle, long enough to pass through.
+    mt19937 rng(110);
+    uniform_real_distribution<float> uniform(-1, 1);
+    RayBatch3D rays;
+    const int count = 100000;
+    for (int c = 0; c < count; c++) {
+        vec3 origin = 5.0f * normalize(vec3(uniform(rng), uniform(rng), uniform(rng)));
+        vec3 target = 1.5f * vec3(uniform(rng), uniform(rng), uniform(rng));
+        rays.add(origin, 2.0f * (target - origin));
+    }
+
+    printf("%8s  %8s  %8s  %8s  %8s  %9s  %9s  %8s  %8s  %8s  %8s\n", "RAYS", "HITS", "RAY_US", "AVG_ITER",
+           "MAX_ITER", "AVG_CALLS", "HULL_MS", "HULL_HIT", "MISSED", "LATE", "EARLY");
+    vector<RayHit> results(count);
+    vector<char> hits(count);
+    long long iterations = 0, calls = 0;
+    int hitCount = 0, maxIterations = 0;
+    start = Clock::now();
+    for (int c = 0; c < count; c++) {
+        vec3 origin = vec3(rays.originX[c], rays.originY[c], rays.originZ[c]);
+        vec3 translation = vec3(rays.translationX[c], rays.translationY[c], rays.translationZ[c]);
+        hits[c] = gjkRaycast(shipped.object, origin, translation, &results[c]);
+        hitCount += hits[c];
+        iterations += results[c].iterations;
+        calls += results[c].supportCalls;
+        maxIterations = std::max(maxIterations, results[c].iterations);
+    }
+    double rayMicros = millisSince(start) * 1000 / count;
+
+    // The hull is inside the object, so every ray that reaches the hull must have hit the object, and no later than it
+    // entered the hull. Those rays pass through the object, so a little past the hit point they must be inside it.
+    int hullHits = 0, missed = 0, late = 0, early = 0;
+    PointCollider3D shift;
+    AddCollider3D shifted;
+    shifted.a = shipped.object;
+    shifted.b = &shift;
+    for (int c = 0; c < count; c++) {
+        vec3 origin = vec3(rays.originX[c], rays.originY[c], rays.originZ[c]);
+        vec3 translation = vec3(rays.translationX[c], rays.translationY[c], rays.translationZ[c]);
+        float fraction;
+        if (!hullRaycast(hull, origin, translation, &fraction)) continue;
+        hullHits++;
+        if (!hits[c]) {
+            missed++;
+            continue;
+        }
+        late += results[c].fraction > fraction;
+        shift.point = -(origin + (results[c].fraction + 1e-3f / length(translation)) * translation);
+        early += !gjkContainsOrigin(&shifted);
+    }
+    printf("%8d  %8d  %8.2f  %8.2f  %8d  %9.2f  %9.2f  %8d  %8d  %8d  %8d\n", count, hitCount, rayMicros,
+           double(iterations) / count, maxIterations, double(calls) / count, hullMillis, hullHits, missed, late, early);
+
+    // The batch must give every ray exactly the same answer.
+    RayBatchHits3D batch;
+    start = Clock::now();
+    gjkRaycast(shipped.object, rays, &batch);
+    double batchMicros = millisSince(start) * 1000 / count;
+    int mismatches = 0;
+    for (int c = 0; c < count; c++) {
+        const RayHit &hit = results[c];
+        if (batch.hit[c] != hits[c] || batch.fraction[c] != hit.fraction || batch.normalX[c] != hit.normal.x ||
+            batch.normalY[c] != hit.normal.y || batch.normalZ[c] != hit.normal.z) {
+            mismatches++;
+        }
+    }
+    printf("batch of %d on %u threads: %.2f us per ray, %d mismatches\n", count, sharedWorkerPool().threadCount(),
+           batchMicros, mismatches);
+
+    // Rounded clouds thrown at the object. Just before the hit they must be apart, and just after, overlapping.
+    const int casts = 10000;
+    vector<vec3> points;
+    randomSphere(points, 64, 111);
+    PointHullCollider3D cloud;
+    cloud.setPoints(points);
+    SphereCollider3D sphere;
+    sphere.radius = 0.1f;
+    AddCollider3D rounded;
+    rounded.a = &cloud;
+    rounded.b = &sphere;
+    PointCollider3D position;
+    AddCollider3D moved;
+    moved.a = &rounded;
+    moved.b = &position;
+    long long castIterations = 0, castCalls = 0;
+    int castHits = 0, wrong = 0;
+    double castMillis = 0;
+    for (int c = 0; c < casts; c++) {
+        position.point = vec3(rays.originX[c], rays.originY[c], rays.originZ[c]);
+        vec3 translation = vec3(rays.translationX[c], rays.translationY[c], rays.translationZ[c]);
+        RayHit hit;
+        start = Clock::now();
+        bool touched = gjkShapeCast(&moved, translation, shipped.object, &hit);
+        castMillis += millisSince(start);
+        castIterations += hit.iterations;
+        castCalls += hit.supportCalls;
+        if (!touched) continue;
+        castHits++;
+        vec3 origin = position.point;
+        position.point = origin + (hit.fraction - 1e-3f) * translation;
+        if (hit.fraction > 1e-3f && gjkIntersect(&moved, shipped.object)) wrong++;
+        position.point = origin + (hit.fraction + 1e-3f) * translation;
+        if (!gjkIntersect(&moved, shipped.object)) wrong++;
+    }
+    printf("%d shape casts: %d hits, %.2f us per cast, %.2f iterations, %.2f calls, %d wrong\n", casts, castHits,
+           castMillis * 1000 / casts, double(castIterations) / casts, double(castCalls) / casts, wrong);
+    printf("\n");
+}
+
+// Whether a and b overlap anywhere in the step, by testing it at many times.
+static bool overlapsDuringStep(Collider3D *a, const Motion3D &motionA, Collider3D *b, const Motion3D &motionB,
+                               int samples) {
+    TransformCollider3D posedA, posedB;
+    posedA.inner = a;
+    posedB.inner = b;
+    for (int c = 0; c <= samples; c++) {
+        float t = samples > 0 ? float(c) / samples : 0;
+        posedA.rotation = motionA.rotationAt(t);
+        posedA.position = motionA.positionAt(t);
+        posedB.rotation = motionB.rotationAt(t);
+        posedB.position = motionB.positionAt(t);
+        if (gjkIntersect(&posedA, &posedB)) return true;
+    }
+    return false;
+}
+
+static void benchTimeOfImpact() {
+    printf("time_of_impact: rounded clouds thrown at each other, by conservative advancement vs testing the end pose\n");
+    const int pairs = 4096;
+    vector<PointHullCollider3D> clouds(pairs);
+    vector<SphereCollider3D> spheres(pairs);
+    vector<AddCollider3D> rounded(pairs);
+    for (int c = 0; c < pairs; c++) {
+        vector<vec3> points;
+        randomSphere(points, 64, 4000 + c);
+        for (vec3 &pt : points) pt *= 0.5f;
+        clouds[c].setPoints(points);
+        spheres[c].radius = 0.05f;
+        rounded[c].a = &clouds[c];
+        rounded[c].b = &spheres[c];
+    }
+
+    // Each pair starts 3 apart, closing at 3 to 9 per step, aimed roughly at each other, so most that meet would pass
+    // through each other between the start and end poses.
+    printf("%8s  %6s  %8s  %8s  %8s  %8s  %9s  %8s  %8s  %8s  %8s  %8s\n", "MOTION", "PAIRS", "TOI_US", "AVG_ITER",
+           "MAX_ITER", "GJK_ITER", "AVG_CALLS", "HITS", "UNCONV", "END_HITS", "TUNNEL", "TOO_LATE");
+    for (int spinning = 0; spinning < 2; spinning++) {
+        mt19937 rng(120);
+        uniform_real_distribution<float> uniform(-1, 1);
+        vector<Motion3D> motionsA(pairs), motionsB(pairs);
+        for (int c = 0; c < pairs; c++) {
+            vec3 gap = 3.0f * normalize(vec3(uniform(rng), uniform(rng), uniform(rng)));
+            motionsA[c].position = vec3(uniform(rng), uniform(rng), uniform(rng));
+            motionsB[c].position = motionsA[c].position + gap;
+            motionsA[c].linear = (2 + uniform(rng)) * gap + 2.0f * vec3(uniform(rng), uniform(rng), uniform(rng));
+            if (spinning) {
+                motionsA[c].angular = 3.0f * vec3(uniform(rng), uniform(rng), uniform(rng));
+                motionsB[c].angular = 3.0f * vec3(uniform(rng), uniform(rng), uniform(rng));
+            }
+        }
+
+        ImpactSettings settings;
+        vector<ImpactResult> results(pairs);
+        Clock::time_point start = Clock::now();
+        for (int c = 0; c < pairs; c++) {
+            timeOfImpact(&rounded[c], motionsA[c], &rounded[(c + 1) % pairs], motionsB[c], settings, &results[c]);
+        }
+        double micros = millisSince(start) * 1000 / pairs;
+
+        // A miss must not overlap anywhere in the step, and a hit must still be apart at its time, but not by more
+        // than the tolerance. Testing only the end pose catches few of them.
+        long long iterations = 0, distanceIterations = 0, calls = 0;
+        int maxIterations = 0, hits = 0, unconverged = 0, endHits = 0, tunnel = 0, late = 0;
+        for (int c = 0; c < pairs; c++) {
+            const ImpactResult &result = results[c];
+            Collider3D *a = &rounded[c], *b = &rounded[(c + 1) % pairs];
+            iterations += result.iterations;
+            distanceIterations += result.distanceIterations;
+            calls += result.supportCalls;
+            maxIterations = std::max(maxIterations, result.iterations);
+            TransformCollider3D endA, endB;
+            endA.inner = a;
+            endA.rotation = motionsA[c].rotationAt(1);
+            endA.position = motionsA[c].positionAt(1);
+            endB.inner = b;
+            endB.rotation = motionsB[c].rotationAt(1);
+            endB.position = motionsB[c].positionAt(1);
+            endHits += gjkIntersect(&endA, &endB);
+            if (result.status == IMPACT_NONE) {
+                tunnel += overlapsDuringStep(a, motionsA[c], b, motionsB[c], 256);
+                continue;
+            }
+            hits++;
+            unconverged += result.status == IMPACT_UNCONVERGED;
+            Motion3D restA = motionsA[c], restB = motionsB[c];
+            restA.position = motionsA[c].positionAt(result.time);
+            restA.rotation = motionsA[c].rotationAt(result.time);
+            restA.linear = restB.linear = restA.angular = restB.angular = vec3(0);
+            restB.position = motionsB[c].positionAt(result.time);
+            restB.rotation = motionsB[c].rotationAt(result.time);
+            late += overlapsDuringStep(a, restA, b, restB, 0);
+        }
+        printf("%8s  %6d  %8.2f  %8.2f  %8d  %8.2f  %9.2f  %8d  %8d  %8d  %8d  %8d\n", spinning ? "spinning" : "linear",
+               pairs, micros, double(iterations) / pairs, maxIterations, double(distanceIterations) / pairs,
+               double(calls) / pairs, hits, unconverged, endHits, tunnel, late);
+    }
+    printf("\n");
+}
+
+static void benchSweep() {
+    printf("sweep: a rounded cloud swept along a translation, as a swept collider vs adding a two point segment\n");
+    vector<vec3> points;
+    randomSphere(points, 1024, 130);
+    PointHullCollider3D cloud;
+    cloud.setPoints(points);
+    SphereCollider3D sphere;
+    sphere.radius = 0.1f;
+    AddCollider3D rounded;
+    rounded.a = &cloud;
+    rounded.b = &sphere;
+
+    vec3 translation = vec3(1.5f, 0.5f, -0.25f);
+    SweptCollider3D swept;
+    swept.inner = &rounded;
+    swept.translation = translation;
+    PointHullCollider3D segment;
+    segment.setPoints({vec3(0), translation});
+    AddCollider3D added;
+    added.a = &rounded;
+    added.b = &segment;
+
+    vector<vec3> dirs = randomDirections(1 << 16, 131);
+    int mismatches = 0;
+    for (const vec3 &dir : dirs) mismatches += swept.findSupport(dir) != added.findSupport(dir);
+    double segmentMicros = timeSupport(segment, dirs), addedMicros = timeSupport(added, dirs);
+    double sweptMicros = timeSupport(swept, dirs), innerMicros = timeSupport(rounded, dirs);
+    printf("support: inner %.3f us, swept %.3f us, added %.3f us (segment alone %.3f us), %d mismatches\n",
+           innerMicros, sweptMicros, addedMicros, segmentMicros, mismatches);
+
+    printf("%9s  %9s  %9s  %9s\n", "COLLIDER", "HULL_MS", "TRIANGLES", "GJK_US");
+    mt19937 rng(132);
+    uniform_real_distribution<float> uniform(-2, 3);
+    vector<vec3> offsets;
+    for (int c = 0; c < 100000; c++) offsets.push_back(vec3(uniform(rng), uniform(rng), uniform(rng)));
+    vector<char> inside[2];
+    for (int c = 0; c < 2; c++) {
+        Collider3D *object = c == 0 ? (Collider3D *) &swept : &added;
+        Clock::time_point start = Clock::now();
+        SurfaceState state;
+        state.object = object;
+        state.epsilon = 0.005f;
+        finishHull(&state);
+        double hullMillis = millisSince(start);
+
+        PointCollider3D shift;
+        AddCollider3D shifted;
+        shifted.a = object;
+        shifted.b = &shift;
+        start = Clock::now();
+        for (const vec3 &offset : offsets) {
+            shift.point = -offset;
+            inside[c].push_back(gjkContainsOrigin(&shifted));
+        }
+        double gjkMicros = millisSince(start) * 1000 / offsets.size();
+        printf("%9s  %9.2f  %9d  %9.3f\n", c == 0 ? "swept" : "added", hullMillis, int(state.triangles.size()),
+               gjkMicros);
+    }
+    int disagree = 0;
+    for (size_t c = 0; c < offsets.size(); c++) disagree += inside[0][c] != inside[1][c];
+    printf("%d of %d containment queries disagree\n", disagree, int(offsets.size()));
+    printf("\n");
+}
+
+static void writeSceneConfig(const char *path, int bodies, float size, unsigned seed) {
+    FILE *file = fopen(path, "w");
+    if (!file) return;
+    fprintf(file, "cube points  -0.5 -0.5 -0.5  0.5 -0.5 -0.5  -0.5 0.5 -0.5  0.5 0.5 -0.5  "
+                  "-0.5 -0.5 0.5  0.5 -0.5 0.5  -0.5 0.5 0.5  0.5 0.5 0.5\n");
+    fprintf(file, "tet points  0 -0.5 0.5  0 -0.5 -0.5  0 0.5 0  0.5 0 0\n");
+    fprintf(file, "ball sphere 0.4\n");
+    fprintf(file, "pill sweep ball 0.4 0 0\n");
+    const char *shapes[] = {"cube", "tet", "ball", "pill"};
+    mt19937 rng(seed);
+    uniform_real_distribution<float> uniform(0, 1);
+    for (int c = 0; c < bodies; c++) {
+        fprintf(file, "body b%d %s %g %g %g %g %g %g\n", c, shapes[c % 4], uniform(rng) * size, uniform(rng) * size,
+                uniform(rng) * size, uniform(rng) * 3, uniform(rng) * 3, uniform(rng) * 3);
+    }
+    fclose(file);
+}
+
+// Moves every object by a small random step, like a frame of a simulation.
+static void jiggle(Scene3D &scene, mt19937 &rng, float step) {
+    uniform_real_distribution<float> uniform(-1, 1);
+    for (uint32_t id = 0; id < scene.objects().size(); id++) {
+        const TransformCollider3D &posed = scene.objects()[id].posed;
+        vec3 spin = vec3(uniform(rng), uniform(rng), uniform(rng)) * step;
+        vec3 move = vec3(uniform(rng), uniform(rng), uniform(rng)) * step;
+        scene.setPose(id, axisAngleRotation(spin) * posed.rotation, posed.position + move);
+    }
+}
+
+static bool boxesOverlap(const SceneObject3D &a, const SceneObject3D &b) {
+    return all(lessThan(a.lower, b.upper)) && all(lessThan(b.lower, a.upper));
+}
+
+static void benchScene() {
+    printf("scene: sweep and prune over loaded bodies, moving a little each frame, then gjk on the candidate pairs\n");
+    const char *path = "bench_scene.txt";
+
+    // Brute force over every pair of a small scene, frame by frame, with steps big enough to swap often.
+    int mismatches = 0;
+    {
+        writeSceneConfig(path, 2000, 25, 140);
+        ColliderArena colliders;
+        Scene3D scene;
+        loadScene(path, &scene, &colliders);
+        mt19937 rng(141);
+        for (int frame = 0; frame < 20; frame++) {
+            if (frame > 0) jiggle(scene, rng, 0.2f);
+            scene.update();
+            vector<ScenePair3D> expected;
+            const vector<SceneObject3D> &objects = scene.objects();
+            for (uint32_t a = 0; a < objects.size(); a++) {
+                for (uint32_t b = a + 1; b < objects.size(); b++) {
+                    if (boxesOverlap(objects[a], objects[b])) expected.push_back({a, b});
+                }
+            }
+            mismatches += expected != scene.pairs();
+        }
+    }
+    printf("%d of 20 frames of 2000 bodies disagree with brute force\n", mismatches);
+
+    const int bodies = 100000;
+    writeSceneConfig(path, bodies, 100, 142);
+    ColliderArena colliders;
+    Scene3D scene;
+    Clock::time_point start = Clock::now();
+    loadScene(path, &scene, &colliders);
+    double loadMillis = millisSince(start);
+    BroadphaseStats stats;
+    start = Clock::now();
+    scene.update(&stats);
+    double buildMillis = millisSince(start);
+    printf("%d bodies: loaded in %.1f ms, first update %.1f ms (rebuilt %d), %d pairs\n", int(scene.objects().size()),
+           loadMillis, buildMillis, int(stats.rebuilt), int(scene.pairs().size()));
+
+    printf("%9s  %9s  %9s  %9s  %9s  %9s  %9s\n", "STEP", "POSE_MS", "UPDATE_MS", "SWAPS", "ADDED", "REMOVED", "PAIRS");
+    mt19937 rng(143);
+    for (float step : {0.001f, 0.01f, 0.05f}) {
+        const int frames = 5;
+        double poseMillis = 0, updateMillis = 0;
+        size_t swaps = 0, added = 0, removed = 0;
+        for (int frame = 0; frame < frames; frame++) {
+            start = Clock::now();
+            jiggle(scene, rng, step);
+            poseMillis += millisSince(start);
+            start = Clock::now();
+            scene.update(&stats);
+            scene.pairs();
+            updateMillis += millisSince(start);
+            swaps += stats.swaps;
+            added += stats.pairsAdded;
+            removed += stats.pairsRemoved;
+        }
+        printf("%9.3f  %9.2f  %9.2f  %9d  %9d  %9d  %9d\n", step, poseMillis / frames, updateMillis / frames,
+               int(swaps / frames), int(added / frames), int(removed / frames), int(scene.pairs().size()));
+    }
+
+    // The incremental pairs should be exactly the ones found sorting the final poses from scratch.
+    Scene3D fresh;
+    for (const SceneObject3D &object : scene.objects()) {
+        fresh.add(object.name, object.posed.inner, object.posed.rotation, object.posed.position);
+    }
+    start = Clock::now();
+    fresh.update();
+    double rebuildMillis = millisSince(start);
+    printf("rebuild from scratch %.1f ms, %s the incremental pairs\n", rebuildMillis,
+           fresh.pairs() == scene.pairs() ? "matches" : "DIFFERS FROM");
+
+    const vector<ScenePair3D> &pairs = scene.pairs();
+    int touching = 0;
+    start = Clock::now();
+    for (const ScenePair3D &pair : pairs) {
+        SubCollider3D difference = scene.difference(pair);
+        touching += gjkContainsOrigin(&difference);
+    }
+    double narrowMillis = millisSince(start);
+    printf("narrowphase: %d of %d candidate pairs touch, %.1f ms, %.3f us per pair\n", touching, int(pairs.size()),
+           narrowMillis, narrowMillis * 1000 / pairs.size());
+    remove(path);
+    printf("\n");
+}
+
+static bool sameResults(const PairBatchResults3D &x, const PairBatchResults3D &y) {
+    return x.overlap == y.overlap && x.separation == y.separation && x.normalX == y.normalX &&
+           x.normalY == y.normalY && x.normalZ == y.normalZ && x.witnessAX == y.witnessAX &&
+           x.witnessAY == y.witnessAY && x.witnessAZ == y.witnessAZ && x.witnessBX == y.witnessBX &&
+           x.witnessBY == y.witnessBY && x.witnessBZ == y.witnessBZ && x.supportCalls == y.supportCalls;
+}
+
+static void benchNarrowphase() {
+    printf("narrowphase: the candidate pairs of a scene, queried one by one vs as a batch on pools of several sizes\n");
+    const char *path = "bench_narrowphase.txt";
+    writeSceneConfig(path, 100000, 100, 150);
+    ColliderArena colliders;
+    Scene3D scene;
+    loadScene(path, &scene, &colliders);
+    remove(path);
+    scene.update();
+    PairBatch3D batch;
+    for (const ScenePair3D &pair : scene.pairs()) batch.add(&scene.object(pair.a).posed, &scene.object(pair.b).posed);
+    size_t count = batch.size();
+    const float epsilon = 1e-3f;
+
+    WorkerPool single(0), several(3);
+    printf("%9s  %7s  %10s  %10s  %10s  %10s  %10s  %9s\n", "QUERY", "PAIRS", "ALONE_MS", "1_THREAD", "4_THREADS",
+           "SHARED_MS", "MPAIRS/S", "IDENTICAL");
+    const char *names[] = {"overlap", "distance", "contact"};
+    for (int query = PAIR_OVERLAP; query <= PAIR_CONTACT; query++) {
+        // Each query alone, the way callers did before: a difference collider per pair, and EPA allocating its mesh.
+        Clock::time_point start = Clock::now();
+        int overlaps = 0;
+        for (size_t c = 0; c < count; c++) {
+            SubCollider3D difference;
+            difference.a = batch.a[c];
+            difference.b = batch.b[c];
+            if (query == PAIR_OVERLAP) {
+                overlaps += gjkContainsOrigin(&difference);
+                continue;
+            }
+            DistanceResult distance;
+            if (gjkDistance(&difference, nullptr, &distance)) continue;
+            overlaps++;
+            PenetrationResult penetration;
+            if (query == PAIR_CONTACT) epaPenetration(batch.a[c], batch.b[c], epsilon, &penetration);
+        }
+        double aloneMillis = millisSince(start);
+
+        PairBatchResults3D results[3];
+        double millis[3];
+        WorkerPool *pools[3] = {&single, &several, &sharedWorkerPool()};
+        for (int p = 0; p < 3; p++) {
+            queryPairs(batch, PairQuery(query), epsilon, &results[p], *pools[p]); // grows the buffers
+            start = Clock::now();
+            queryPairs(batch, PairQuery(query), epsilon, &results[p], *pools[p]);
+            millis[p] = millisSince(start);
+        }
+        bool identical = sameResults(results[0], results[1]) && sameResults(results[0], results[2]);
+        int batchOverlaps = 0;
+        for (uint8_t overlap : results[0].overlap) batchOverlaps += overlap;
+        printf("%9s  %7d  %10.1f  %10.1f  %10.1f  %10.1f  %10.2f  %9s\n", names[query], int(count), aloneMillis,
+               millis[0], millis[1], millis[2], count / millis[2] / 1000,
+               identical && batchOverlaps == overlaps ? "yes" : "NO");
+    }
+    printf("shared pool has %u threads\n\n", sharedWorkerPool().threadCount());
+}
+
+// How far point is outside shape, or 0 if it's inside.
+static float outsideShape(Collider3D *shape, vec3 point) {
+    PointCollider3D at;
+    at.point = point;
+    DistanceResult distance;
+    gjkDistance(shape, &at, &distance);
+    return distance.distance;
+}
+
+static void benchManifold() {
+    printf("manifold: contacts of shapes resting on a box, then a jiggling scene with and without the cache\n");
+    vector<vec3> cubePoints;
+    for (int c = 0; c < 8; c++) cubePoints.push_back(vec3(c & 1, (c >> 1) & 1, (c >> 2) & 1) - vec3(0.5f));
+    PointHullCollider3D cube, slab;
+    cube.setPoints(cubePoints);
+    vector<vec3> slabPoints = cubePoints;
+    for (vec3 &pt : slabPoints) pt *= vec3(8, 1, 8);
+    slab.setPoints(slabPoints);
+    SphereCollider3D ball, rounding;
+    ball.radius = 0.4f;
+    rounding.radius = 0.05f;
+    AddCollider3D roundedCube;
+    roundedCube.a = &cube;
+    roundedCube.b = &rounding;
+    SweptCollider3D pill;
+    pill.inner = &ball;
+    pill.translation = vec3(0.8f, 0, 0);
+
+    // Each shape sinks 0.02 into the top of the slab, turned a little about the vertical so no edges line up.
+    struct Resting {
+        const char *name;
+        Collider3D *shape;
+        float halfHeight;
+        int expected;
+    };
+    Resting shapes[] = {{"cube", &cube, 0.5f, 4}, {"rounded", &roundedCube, 0.55f, 4}, {"ball", &ball, 0.4f, 1},
+                        {"pill", &pill, 0.4f, 2}};
+    printf("%9s  %7s  %9s  %9s  %11s  %9s\n", "SHAPE", "POINTS", "EXPECTED", "DEPTH_ERR", "SURFACE_ERR", "CALLS");
+    TransformCollider3D ground;
+    ground.inner = &slab;
+    for (const Resting &resting : shapes) {
+        TransformCollider3D posed;
+        posed.inner = resting.shape;
+        posed.rotation = axisAngleRotation(vec3(0, 0.3f, 0));
+        posed.position = vec3(0.1f, 0.5f + resting.halfHeight - 0.02f, -0.2f);
+        ContactManifold3D manifold;
+        contactManifold(&ground, &posed, 1e-4f, &manifold);
+        float depthError = 0, surfaceError = 0;
+        for (int c = 0; c < manifold.count; c++) {
+            const ContactPoint3D &point = manifold.points[c];
+            depthError = std::max(depthError, std::abs(point.depth - 0.02f));
+            surfaceError = std::max(surfaceError, std::max(outsideShape(&ground, point.onA),
+                                                           outsideShape(&posed, point.onB)));
+        }
+        printf("%9s  %7d  %9d  %9.2g  %11.2g  %9d\n", resting.name, manifold.count, resting.expected, depthError,
+               surfaceError, manifold.supportCalls);
+    }
+
+    const char *path = "bench_manifold.txt";
+    writeSceneConfig(path, 20000, 58, 160);
+    ColliderArena colliders;
+    Scene3D scene;
+    loadScene(path, &scene, &colliders);
+    remove(path);
+
+    // The cache is filled by a frame before each step size is timed, and rebuilds every pair that moved too far since.
+    printf("%9s  %9s  %9s  %9s  %9s  %11s  %9s  %9s\n", "STEP", "FRAME_MS", "CACHED_MS", "CONTACTS", "REUSED", "CALLS",
+           "CACHED", "DEPTH_ERR");
+    mt19937 rng(161);
+    ManifoldCache3D cache;
+    EpaScratch scratch;
+    for (float step : {0.0005f, 0.002f, 0.01f}) {
+        const int frames = 4;
+        double frameMillis = 0, cachedMillis = 0;
+        size_t contacts = 0, calls = 0, returned = 0;
+        float depthError = 0;
+        ManifoldStats stats;
+        for (int frame = -1; frame < frames; frame++) {
+            if (frame == 0) {
+                frameMillis = cachedMillis = 0;
+                contacts = calls = returned = 0;
+                stats = ManifoldStats();
+            }
+            jiggle(scene, rng, step);
+            scene.update();
+            const vector<ScenePair3D> &pairs = scene.pairs();
+            vector<ContactManifold3D> fresh(pairs.size());
+            vector<uint8_t> touching(pairs.size());
+            Clock::time_point start = Clock::now();
+            for (size_t c = 0; c < pairs.size(); c++) {
+                touching[c] = contactManifold(&scene.object(pairs[c].a).posed, &scene.object(pairs[c].b).posed, 1e-3f,
+                                              &fresh[c], &scratch);
+                calls += fresh[c].supportCalls;
+                contacts += touching[c];
+            }
+            frameMillis += millisSince(start);
+
+            start = Clock::now();
+            vector<const ContactManifold3D *> cached(pairs.size());
+            for (size_t c = 0; c < pairs.size(); c++) {
+                cached[c] = cache.update(pairs[c].key(), &scene.object(pairs[c].a).posed,
+                                         &scene.object(pairs[c].b).posed, &stats);
+                returned += cached[c] != nullptr;
+            }
+            cache.endFrame(&stats);
+            cachedMillis += millisSince(start);
+            // Reused manifolds should keep the depths of fresh ones, to within how far the pairs may move.
+            for (size_t c = 0; c < pairs.size(); c++) {
+                if (!touching[c] || !cached[c] || cached[c]->count != fresh[c].count) continue;
+                float deepestFresh = -numeric_limits<float>::infinity(), deepestCached = deepestFresh;
+                for (int k = 0; k < fresh[c].count; k++) {
+                    deepestFresh = std::max(deepestFresh, fresh[c].points[k].depth);
+                }
+                for (int k = 0; k < cached[c]->count; k++) {
+                    deepestCached = std::max(deepestCached, cached[c]->points[k].depth);
+                }
+                depthError = std::max(depthError, std::abs(deepestFresh - deepestCached));
+            }
+        }
+        printf("%9.4f  %9.1f  %9.1f  %9d  %8.1f%%  %11d  %9d  %9.2g\n", step, frameMillis / frames,
+               cachedMillis / frames, int(contacts / frames), 100.0 * stats.reused / std::max<size_t>(1, returned),
+               int(calls / frames), int(stats.supportCalls / frames), depthError);
+    }
+    printf("\n");
+}
+
+static void benchSeparationCache() {
+    printf("separation_cache: overlap queries on a jiggling scene's pairs, cold vs from each pair's cached axis\n");
+    const char *path = "bench_separation_cache.txt";
+    writeSceneConfig(path, 20000, 58, 170);
+    ColliderArena colliders;
+    Scene3D scene;
+    loadScene(path, &scene, &colliders);
+    remove(path);
+
+    // The cache is filled by a frame before each step size is timed.
+    printf("%9s  %7s  %9s  %9s  %8s  %9s  %9s  %9s  %9s\n", "STEP", "PAIRS", "COLD_MS", "CACHED_MS", "HITS",
+           "COLD_CALLS", "CALLS", "SAVED", "DISAGREE");
+    mt19937 rng(171);
+    SeparationCache3D cache;
+    for (float step : {0.0005f, 0.002f, 0.01f, 0.05f}) {
+        const int frames = 4;
+        double coldMillis = 0, cachedMillis = 0;
+        size_t pairCount = 0, coldCalls = 0, disagree = 0;
+        SeparationCacheStats stats;
+        for (int frame = -1; frame < frames; frame++) {
+            if (frame == 0) {
+                coldMillis = cachedMillis = 0;
+                pairCount = coldCalls = disagree = 0;
+                stats = SeparationCacheStats();
+            }
+            jiggle(scene, rng, step);
+            scene.update();
+            const vector<ScenePair3D> &pairs = scene.pairs();
+            pairCount += pairs.size();
+            vector<uint8_t> cold(pairs.size()), cached(pairs.size());
+            Clock::time_point start = Clock::now();
+            for (size_t c = 0; c < pairs.size(); c++) {
+                GjkStats gjk;
+                cold[c] = gjkIntersect(&scene.object(pairs[c].a).posed, &scene.object(pairs[c].b).posed, &gjk);
+                coldCalls += gjk.supportCalls;
+            }
+            coldMillis += millisSince(start);
+
+            start = Clock::now();
+            for (size_t c = 0; c < pairs.size(); c++) {
+                cached[c] = cache.intersect(&scene.object(pairs[c].a).posed, &scene.object(pairs[c].b).posed, &stats);
+            }
+            cache.endFrame(&stats);
+            cachedMillis += millisSince(start);
+            for (size_t c = 0; c < pairs.size(); c++) disagree += cold[c] != cached[c];
+        }
+        printf("%9.4f  %7d  %9.2f  %9.2f  %7.1f%%  %9d  %9d  %9d  %9d\n", step, int(pairCount / frames),
+               coldMillis / frames, cachedMillis / frames, 100.0 * stats.hits / std::max<size_t>(1, stats.queries),
+               int(coldCalls / frames), int(stats.supportCalls / frames), int(stats.savedSupportCalls / frames),
+               int(disagree));
+    }
+    printf("\n");
+}
+
+struct Benchmark {
+    const char *name;
+    void (*run)();
+};
+
+static const Benchmark benchmarks[] = {
+    {"exact_sum", benchExactSum},
+    {"points_reduction", benchPointsReduction},
+    {"support_scan", benchSupportScan},
+    {"parallel_scan", benchParallelScan},
+    {"clustered_scan", benchClusteredScan},
+    {"support_map", benchSupportMap},
+    {"shared_symbols", benchSharedSymbols},
+    {"bake", benchBake},
+    {"hull_cache", benchHullCache},
+    {"hull_file", benchHullFile},
+    {"streaming", benchStreaming},
+    {"config_parse", benchConfigParse},
+    {"points_file", benchPointsFile},
+    {"symbol_table", benchSymbolTable},
+    {"gjk_intersect", benchGjkIntersect},
+    {"epa", benchEpa},
+    {"gjk_distance", benchGjkDistance},
+    {"raycast", benchRaycast},
+    {"time_of_impact", benchTimeOfImpact},
+    {"sweep", benchSweep},
+    {"scene", benchScene},
+    {"narrowphase", benchNarrowphase},
+    {"manifold", benchManifold},
+    {"separation_cache", benchSeparationCache},
+};
+
+int main(int argc, char **argv) {
+    for (const Benchmark &bench : benchmarks) {
+        bool selected = argc <= 1;
+        for (int c = 1; c < argc; c++) {
+            if (strcmp(argv[c], bench.name) == 0) selected = true;
+        }
+        if (selected) bench.run();
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+//
+// Sublinear support queries on large point clouds, by branch and bound over spatial clusters.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "clusteredPoints3D.h"
+
+using namespace std;
+using namespace glm;
+
+static const size_t kClusterSize = 64;
+static const float kBoundSlack = 1e-5f; // relative, covers the rounding of both the bound and the dot products
+
+static uint32_t buildNode(ClusteredPointsCollider3D &collider, const vector<vec3> &points, vector<uint32_t> &order,
+                          size_t begin, size_t end) {
+    vec3 lo = points[order[begin]], hi = lo;
+    for (size_t c = begin; c < end; c++) {
+        lo = min(lo, points[order[c]]);
+        hi = max(hi, points[order[c]]);
+    }
+    vec3 center = (lo + hi) * 0.5f;
+    float radius = 0;
+    for (size_t c = begin; c < end; c++) radius = std::max(radius, length(points[order[c]] - center));
+
+    uint32_t index = uint32_t(collider.nodes.size());
+    collider.nodes.emplace_back();
+    ClusteredPointsCollider3D::Node node;
+    node.center = center;
+    node.radius = radius + kBoundSlack * (length(center) + radius);
+
+    if (end - begin <= kClusterSize) {
+        // Sorting by original index makes the first maximum in a leaf the one a linear scan would find.
+        sort(order.begin() + begin, order.begin() + end);
+        node.leaf = true;
+        node.first = uint32_t(collider.xs.size());
+        size_t size = end - begin;
+        size_t padded = (size + kSupportScanLanes - 1) / kSupportScanLanes * kSupportScanLanes;
+        for (size_t c = 0; c < padded; c++) {
+            uint32_t original = order[begin + std::min(c, size - 1)];
+            collider.xs.push_back(points[original].x);
+            collider.ys.push_back(points[original].y);
+            collider.zs.push_back(points[original].z);
+            collider.indices.push_back(original);
+        }
+        node.second = uint32_t(collider.xs.size());
+    } else {
+        vec3 extent = hi - lo;
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+        size_t mid = begin + (end - begin) / 2;
+        nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                    [&](uint32_t a, uint32_t b) { return points[a][axis] < points[b][axis]; });
+        node.leaf = false;
+        node.first = buildNode(collider, points, order, begin, mid);
+        node.second = buildNode(collider, points, order, mid, end);
+    }
+    collider.nodes[index] = node;
+    return index;
+}
+
+void ClusteredPointsCollider3D::setPoints(const vector<vec3> &points) {
+    count = points.size();
+    nodes.clear();
+    xs.clear();
+    ys.clear();
+    zs.clear();
+    indices.clear();
+    if (count == 0) return;
+
+    vector<uint32_t> order(count);
+    for (size_t c = 0; c < count; c++) order[c] = uint32_t(c);
+    buildNode(*this, points, order, 0, count);
+}
+
+vector<vec3> ClusteredPointsCollider3D::points() const {
+    vector<vec3> points(count);
+    for (size_t c = 0, n = xs.size(); c < n; c++) points[indices[c]] = vec3(xs[c], ys[c], zs[c]);
+    return points;
+}
+
+// Returns the slot of the support point in the coordinate arrays.
+static size_t findSupportSlot(const ClusteredPointsCollider3D &collider, vec3 direction, size_t *visited) {
+    typedef ClusteredPointsCollider3D::Node Node;
+    const vector<Node> &nodes = collider.nodes;
+    float scale = length(direction);
+    float bestDot = -numeric_limits<float>::infinity();
+    size_t best = 0;
+
+    // Infinite or NaN coordinates make the bounds useless, so every leaf is scanned. The scan starts from point 0, not
+    // slot 0, since that is what PointHullCollider3D returns when no dot product is a number above -infinity.
+    bool finite = std::isfinite(direction.x) && std::isfinite(direction.y) && std::isfinite(direction.z);
+    if (!finite) best = size_t(find(collider.indices.begin(), collider.indices.end(), 0u) - collider.indices.begin());
+
+    uint32_t stack[64]; // the tree is balanced, so it is never this deep
+    int depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0) {
+        const Node &node = nodes[stack[--depth]];
+        // Equal bounds are still visited, since they may hold a tie with a lower index.
+        if (finite && dot(node.center, direction) + node.radius * scale < bestDot) continue;
+
+        if (node.leaf) {
+            float leafDot;
+            size_t slot = node.first + supportScan(&collider.xs[node.first], &collider.ys[node.first],
+                                                   &collider.zs[node.first], node.second - node.first,
+                                                   direction, &leafDot);
+            if (leafDot > bestDot || (leafDot == bestDot && collider.indices[slot] < collider.indices[best])) {
+                bestDot = leafDot;
+                best = slot;
+            }
+            if (visited) *visited += node.second - node.first;
+            continue;
+        }
+
+        // Push the more promising child last, so it is searched first.
+        const Node &a = nodes[node.first];
+        const Node &b = nodes[node.second];
+        float boundA = dot(a.center, direction) + a.radius * scale;
+        float boundB = dot(b.center, direction) + b.radius * scale;
+        if (boundA > boundB) {
+            stack[depth++] = node.second;
+            stack[depth++] = node.first;
+        } else {
+            stack[depth++] = node.first;
+            stack[depth++] = node.second;
+        }
+    }
+    return best;
+}
+
+size_t ClusteredPointsCollider3D::findSupportIndex(vec3 direction, size_t *visited) const {
+    if (count == 0) return 0;
+    return indices[findSupportSlot(*this, direction, visited)];
+}
+
+vec3 ClusteredPointsCollider3D::findSupport(vec3 direction) {
+    if (count == 0) return vec3(0);
+    size_t slot = findSupportSlot(*this, direction, nullptr);
+    return vec3(xs[slot], ys[slot], zs[slot]);
+}
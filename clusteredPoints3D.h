@@ -0,0 +1,38 @@
+//
+// Sublinear support queries on large point clouds, by branch and bound over spatial clusters.
+//
+
+#ifndef MINKOWSKIHULL3D_CLUSTEREDPOINTS3D_H
+#define MINKOWSKIHULL3D_CLUSTEREDPOINTS3D_H
+
+#include "hull3D.h"
+
+// Points are split into a tree of small spatial clusters, each with a bounding sphere. No point in a cluster can have
+// a dot product with d greater than center . d + radius * |d|, so a query visits the most promising clusters first
+// and skips every one whose bound can't beat the best point so far.
+// Returns exactly the same point as PointHullCollider3D, including which of several tied points wins.
+struct ClusteredPointsCollider3D : public Collider3D {
+    struct Node {
+        glm::vec3 center;
+        float radius; // padded to cover rounding in the dot products
+        uint32_t first, second; // children, or for leaves the range of their points in the arrays
+        bool leaf;
+    };
+
+    std::vector<Node> nodes; // the root is first
+    // Points grouped by leaf, sorted by original index within each leaf, with every leaf padded to a multiple of
+    // kSupportScanLanes by repeating its last point.
+    std::vector<float> xs, ys, zs;
+    std::vector<uint32_t> indices; // original index of each stored point
+    size_t count = 0;
+
+    void setPoints(const std::vector<glm::vec3> &points);
+    std::vector<glm::vec3> points() const;
+
+    // The original index of the support point. If visited is given, it is increased by the number of points scanned.
+    size_t findSupportIndex(glm::vec3 direction, size_t *visited = nullptr) const;
+
+    glm::vec3 findSupport(glm::vec3 direction) override;
+};
+
+#endif //MINKOWSKIHULL3D_CLUSTEREDPOINTS3D_H
@@ -0,0 +1,36 @@
+//
+// An arena that owns the colliders of a loaded config.
+//
+
+#include <algorithm>
+#include <cstdint>
+
+#include "colliderArena.h"
+
+using namespace std;
+
+// Big enough for thousands of colliders. Anything bigger gets a block of its own.
+static const size_t kArenaBlockBytes = 64 << 10;
+
+void *ColliderArena::allocate(size_t size, size_t alignment) {
+    uintptr_t aligned = (uintptr_t(cursor) + alignment - 1) / alignment * alignment;
+    if (!cursor || aligned + size > uintptr_t(limit)) {
+        // new[] aligns to the largest fundamental alignment, which covers everything a collider needs.
+        size_t blockSize = max(kArenaBlockBytes, size);
+        blocks.emplace_back(new char[blockSize]);
+        reserved += blockSize;
+        cursor = blocks.back().get();
+        limit = cursor + blockSize;
+        aligned = uintptr_t(cursor);
+    }
+    cursor = reinterpret_cast<char *>(aligned + size);
+    return reinterpret_cast<void *>(aligned);
+}
+
+void ColliderArena::clear() {
+    for (auto it = destructors.rbegin(); it != destructors.rend(); ++it) it->destroy(it->object);
+    destructors.clear();
+    blocks.clear();
+    cursor = limit = nullptr;
+    reserved = 0;
+}
@@ -0,0 +1,51 @@
+//
+// An arena that owns the colliders of a loaded config.
+//
+
+#ifndef MINKOWSKIHULL3D_COLLIDERARENA_H
+#define MINKOWSKIHULL3D_COLLIDERARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Colliders, and anything they depend on like mapped points files, are placed one after another in large blocks, so
+// the nodes of a collider tree share a few pages instead of being scattered over the heap. Nothing is freed on its own.
+// Everything is destroyed at once, in reverse order of creation, by clear() or the arena's destructor.
+class ColliderArena {
+public:
+    ColliderArena() {}
+    ~ColliderArena() { clear(); }
+    ColliderArena(const ColliderArena &) = delete;
+    ColliderArena &operator=(const ColliderArena &) = delete;
+
+    template <typename T, typename... Args>
+    T *make(Args &&... args) {
+        T *object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        destructors.push_back({object, [](void *o) { static_cast<T *>(o)->~T(); }});
+        return object;
+    }
+
+    void clear();
+
+    size_t objectCount() const { return destructors.size(); }
+    size_t blockBytes() const { return reserved; }
+
+private:
+    struct Destructor {
+        void *object;
+        void (*destroy)(void *);
+    };
+
+    void *allocate(size_t size, size_t alignment);
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char *cursor = nullptr;
+    char *limit = nullptr;
+    size_t reserved = 0;
+    std::vector<Destructor> destructors;
+};
+
+#endif //MINKOWSKIHULL3D_COLLIDERARENA_H
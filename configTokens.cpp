@@ -0,0 +1,142 @@
+//
+// Zero copy tokenizing of config lines.
+//
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+
+#include "configTokens.h"
+
+using namespace std;
+
+static inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+static inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Floats hold every integer up to 2^24 and every power of ten up to 10^10 exactly, so a product or quotient of two
+// of them is rounded once, like strtof rounds.
+static const uint64_t kMaxExactMantissa = 1 << 24;
+static const int kMaxExactExponent = 10;
+static const float kPowersOfTen[kMaxExactExponent + 1] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+
+bool parseFloat(const char *&cursor, const char *end, float *out) {
+    const char *c = cursor;
+    bool negative = false;
+    if (c != end && (*c == '+' || *c == '-')) negative = *c++ == '-';
+
+    // Stop accumulating digits before the mantissa can overflow. Numbers that long go to strtof anyway.
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool digits = false, overflow = false;
+    for (; c != end && isDigit(*c); c++) {
+        digits = true;
+        if (mantissa < kMaxExactMantissa * 10) mantissa = mantissa * 10 + (*c - '0');
+        else overflow = true;
+        if (overflow) exponent++;
+    }
+    if (c != end && *c == '.') {
+        c++;
+        for (; c != end && isDigit(*c); c++) {
+            digits = true;
+            if (mantissa < kMaxExactMantissa * 10) {
+                mantissa = mantissa * 10 + (*c - '0');
+                exponent--;
+            } else {
+                overflow = true;
+            }
+        }
+    }
+    if (!digits) return false;
+
+    if (c != end && (*c == 'e' || *c == 'E')) {
+        c++;
+        bool negativeExponent = false;
+        if (c != end && (*c == '+' || *c == '-')) negativeExponent = *c++ == '-';
+        if (c == end || !isDigit(*c)) return false; // an exponent without digits doesn't parse, like in a stream
+        int written = 0;
+        for (; c != end && isDigit(*c); c++) {
+            if (written < 100000) written = written * 10 + (*c - '0');
+        }
+        exponent += negativeExponent ? -written : written;
+    }
+
+    if (!overflow && mantissa <= kMaxExactMantissa && exponent >= -kMaxExactExponent && exponent <= kMaxExactExponent) {
+        float value = float(mantissa);
+        value = exponent < 0 ? value / kPowersOfTen[-exponent] : value * kPowersOfTen[exponent];
+        *out = negative ? -value : value;
+    } else {
+        // Streams fail on numbers beyond the range of floats, where strtof returns infinity, but accept underflow.
+        float value = strtof(string(cursor, c).c_str(), nullptr);
+        if (std::isinf(value)) return false;
+        *out = value;
+    }
+    cursor = c;
+    return true;
+}
+
+static const char *skipSpace(const char *c, const char *end) {
+    while (c != end && isSpace(*c)) c++;
+    return c;
+}
+
+bool ConfigTokens::word(string &out) {
+    if (failed) return false;
+    cursor = skipSpace(cursor, end);
+    const char *begin = cursor;
+    while (cursor != end && !isSpace(*cursor)) cursor++;
+    if (cursor == begin) {
+        failed = true;
+        return false;
+    }
+    out.assign(begin, cursor);
+    return true;
+}
+
+bool ConfigTokens::number(float &out) {
+    if (failed) return false;
+    cursor = skipSpace(cursor, end);
+    if (!parseFloat(cursor, end, &out)) failed = true;
+    return !failed;
+}
+
+bool ConfigTokens::number(int &out) {
+    if (failed) return false;
+    const char *c = skipSpace(cursor, end);
+    bool negative = false;
+    if (c != end && (*c == '+' || *c == '-')) negative = *c++ == '-';
+    if (c == end || !isDigit(*c)) {
+        failed = true;
+        return false;
+    }
+    int64_t value = 0;
+    for (; c != end && isDigit(*c); c++) {
+        value = value * 10 + (*c - '0');
+        if (value > int64_t(numeric_limits<int>::max()) + 1) {
+            failed = true;
+            return false;
+        }
+    }
+    value = negative ? -value : value;
+    if (value > numeric_limits<int>::max()) {
+        failed = true;
+        return false;
+    }
+    out = int(value);
+    cursor = c;
+    return true;
+}
+
+size_t ConfigTokens::countTokens() const {
+    size_t count = 0;
+    for (const char *c = skipSpace(cursor, end); c != end; c = skipSpace(c, end)) {
+        count++;
+        while (c != end && !isSpace(*c)) c++;
+    }
+    return count;
+}
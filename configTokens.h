@@ -0,0 +1,34 @@
+//
+// Zero copy tokenizing of config lines.
+//
+
+#ifndef MINKOWSKIHULL3D_CONFIGTOKENS_H
+#define MINKOWSKIHULL3D_CONFIGTOKENS_H
+
+#include <cstddef>
+#include <string>
+
+// Reads the tokens of one line of a config in place. Follows the rules of extracting them from an istringstream, so
+// configs parse exactly as they used to: whitespace before a token is skipped, numbers take the longest prefix of the
+// text that is one, and once an extraction fails, every later one fails too.
+struct ConfigTokens {
+    const char *cursor;
+    const char *end;
+    bool failed = false;
+
+    ConfigTokens(const char *begin, const char *end) : cursor(begin), end(end) {}
+
+    bool word(std::string &out);
+    bool number(float &out);
+    bool number(int &out);
+
+    // The number of whitespace separated tokens left, for sizing vectors before parsing.
+    size_t countTokens() const;
+};
+
+// Parses the float at the start of [cursor, end) and moves cursor past it, or returns false if there is none.
+// Rounds exactly like strtof, which it falls back to for numbers with too many digits to convert exactly in floats.
+// Like extracting from a stream, numbers beyond the range of floats fail, while ones that underflow round to zero.
+bool parseFloat(const char *&cursor, const char *end, float *out);
+
+#endif //MINKOWSKIHULL3D_CONFIGTOKENS_H
@@ -0,0 +1,278 @@
+//
+// Contact manifolds of up to four points for overlapping colliders, and a cache keeping them between frames.
+//
+
+#include <algorithm>
+#include <cmath>
+
+#include "contactManifold3D.h"
+
+using namespace std;
+using namespace glm;
+
+// The number of directions probed around the normal at each tilt, which is also the most vertices a feature can have.
+static const int kFeatureProbes = 8;
+// A clipped polygon gains at most one vertex per side of the reference feature.
+static const int kMaxClipped = 2 * kFeatureProbes;
+
+struct Feature {
+    vec3 points[kFeatureProbes]; // in order around the normal
+    int count = 0;
+};
+
+// The vertices of shape's core facing along normal. A vertex only counts if the probes at both tilts find exactly the
+// same point, which polytopes do and curved surfaces don't.
+static void findFeature(Collider3D *shape, vec3 normal, Feature *feature, int *supportCalls) {
+    vec3 axis = std::abs(normal.x) < 0.5f ? vec3(1, 0, 0) : vec3(0, 1, 0);
+    vec3 u = normalize(cross(normal, axis)), v = cross(normal, u);
+    float outer = std::sin(kManifoldTilt), inner = std::sin(0.5f * kManifoldTilt);
+    for (int k = 0; k < kFeatureProbes; k++) {
+        float angle = float(k) * 6.28318531f / kFeatureProbes;
+        vec3 tangent = std::cos(angle) * u + std::sin(angle) * v;
+        vec3 p = shape->findCoreSupport(normal * std::sqrt(1 - outer * outer) + tangent * outer);
+        vec3 q = shape->findCoreSupport(normal * std::sqrt(1 - inner * inner) + tangent * inner);
+        *supportCalls += 2;
+        if (p != q) continue;
+        if (feature->count > 0 && feature->points[feature->count - 1] == p) continue;
+        feature->points[feature->count++] = p;
+    }
+    if (feature->count > 1 && feature->points[feature->count - 1] == feature->points[0]) feature->count--;
+}
+
+// Keeps the part of the segment from *p to *q on the inner side of the plane. Returns false if none of it is.
+static bool clipSegment(vec3 *p, vec3 *q, vec3 side, vec3 onSide) {
+    float dp = dot(side, *p - onSide), dq = dot(side, *q - onSide);
+    if (dp > 0 && dq > 0) return false;
+    if (dp > 0) *p += (*q - *p) * (dp / (dp - dq));
+    else if (dq > 0) *q += (*p - *q) * (dq / (dq - dp));
+    return true;
+}
+
+// Sutherland-Hodgman: keeps the part of the polygon on the inner side of the plane.
+static int clipPolygon(const vec3 *in, int count, vec3 side, vec3 onSide, vec3 *out) {
+    int kept = 0;
+    for (int c = 0; c < count; c++) {
+        vec3 p = in[c], q = in[(c + 1) % count];
+        float dp = dot(side, p - onSide), dq = dot(side, q - onSide);
+        if (dp <= 0) out[kept++] = p;
+        if ((dp < 0 && dq > 0) || (dp > 0 && dq < 0)) out[kept++] = p + (q - p) * (dp / (dp - dq));
+    }
+    return kept;
+}
+
+// Picks the four points spanning the most area: the deepest, the one furthest from it, the one making the biggest
+// triangle with those, and the one furthest outside that triangle.
+static void reducePoints(ContactPoint3D *points, int *count, vec3 normal) {
+    if (*count <= kMaxContactPoints) return;
+    int chosen[kMaxContactPoints] = {0, 0, 0, 0};
+    chosen[0] = 0;
+    for (int c = 1; c < *count; c++) {
+        if (points[c].depth > points[chosen[0]].depth) chosen[0] = c;
+    }
+    vec3 first = points[chosen[0]].onB;
+    float best = -1;
+    for (int c = 0; c < *count; c++) {
+        float distance2 = dot(points[c].onB - first, points[c].onB - first);
+        if (distance2 > best) {
+            best = distance2;
+            chosen[1] = c;
+        }
+    }
+    vec3 second = points[chosen[1]].onB;
+    best = -1;
+    float winding = 1;
+    for (int c = 0; c < *count; c++) {
+        float area = dot(cross(second - first, points[c].onB - first), normal);
+        if (std::abs(area) > best) {
+            best = std::abs(area);
+            chosen[2] = c;
+            winding = area < 0 ? -1.0f : 1.0f;
+        }
+    }
+    // Outside the triangle is where the area a point makes with one of its edges has the opposite winding.
+    vec3 corners[3] = {first, second, points[chosen[2]].onB};
+    best = -1;
+    chosen[3] = chosen[0];
+    for (int c = 0; c < *count; c++) {
+        for (int e = 0; e < 3; e++) {
+            vec3 from = corners[e], to = corners[(e + 1) % 3];
+            float outside = -winding * dot(cross(to - from, points[c].onB - from), normal);
+            if (outside > best) {
+                best = outside;
+                chosen[3] = c;
+            }
+        }
+    }
+
+    ContactPoint3D reduced[kMaxContactPoints];
+    for (int k = 0; k < kMaxContactPoints; k++) reduced[k] = points[chosen[k]];
+    *count = 0;
+    for (int k = 0; k < kMaxContactPoints; k++) {
+        bool repeated = false;
+        for (int j = 0; j < k; j++) repeated |= chosen[j] == chosen[k];
+        if (!repeated) points[(*count)++] = reduced[k];
+    }
+}
+
+// Clips the incident feature against the sides of the reference face, and keeps the points within epsilon of it.
+// Returns the number of points, which may be more than kMaxContactPoints.
+static int clipFeatures(const Feature &reference, const Feature &incident, vec3 outward, float margins, float epsilon,
+                        bool referenceIsA, ContactPoint3D *points) {
+    // Newell's normal, which is robust for any number of vertices.
+    vec3 faceNormal = vec3(0), center = vec3(0);
+    for (int c = 0; c < reference.count; c++) {
+        vec3 p = reference.points[c], q = reference.points[(c + 1) % reference.count];
+        faceNormal += cross(p, q);
+        center += p;
+    }
+    center /= float(reference.count);
+    if (faceNormal == vec3(0)) return 0;
+    faceNormal = normalize(faceNormal);
+    if (dot(faceNormal, outward) < 0) faceNormal = -faceNormal;
+
+    vec3 buffers[2][kMaxClipped];
+    int count = incident.count;
+    copy(incident.points, incident.points + count, buffers[0]);
+    int current = 0;
+    for (int c = 0; c < reference.count && count > 0; c++) {
+        vec3 p = reference.points[c], q = reference.points[(c + 1) % reference.count];
+        vec3 side = cross(q - p, faceNormal);
+        if (dot(side, center - p) > 0) side = -side;
+        if (count == 2) {
+            if (!clipSegment(&buffers[current][0], &buffers[current][1], side, p)) count = 0;
+            continue;
+        }
+        count = clipPolygon(buffers[current], count, side, p, buffers[1 - current]);
+        current = 1 - current;
+    }
+
+    int kept = 0;
+    for (int c = 0; c < count; c++) {
+        vec3 p = buffers[current][c];
+        float depth = dot(reference.points[0] - p, faceNormal);
+        if (depth + margins < -epsilon) continue;
+        vec3 onReference = p + depth * faceNormal;
+        ContactPoint3D &point = points[kept++];
+        point.onA = referenceIsA ? onReference : p;
+        point.onB = referenceIsA ? p : onReference;
+        point.depth = depth;
+    }
+    return kept;
+}
+
+void buildManifold(Collider3D *a, Collider3D *b, const PenetrationResult &penetration, float epsilon,
+                   ContactManifold3D *manifold) {
+    vec3 normal = penetration.normal;
+    manifold->normal = normal;
+    manifold->count = 1;
+    manifold->points[0].onA = penetration.witnessA;
+    manifold->points[0].onB = penetration.witnessB;
+    manifold->points[0].depth = penetration.depth;
+    if (normal == vec3(0)) return;
+
+    Feature onA, onB;
+    findFeature(a, normal, &onA, &manifold->supportCalls);
+    findFeature(b, -normal, &onB, &manifold->supportCalls);
+    bool referenceIsA = onA.count >= onB.count;
+    const Feature &reference = referenceIsA ? onA : onB, &incident = referenceIsA ? onB : onA;
+    // Vertices and edges crossing edges touch at a single point, which the penetration already found.
+    if (reference.count < 3 || incident.count < 2) return;
+
+    float marginA = a->margin(), marginB = b->margin();
+    ContactPoint3D points[kMaxClipped];
+    int count = clipFeatures(reference, incident, referenceIsA ? normal : -normal, marginA + marginB, epsilon,
+                             referenceIsA, points);
+    if (count == 0) return;
+    for (int c = 0; c < count; c++) {
+        points[c].onA += marginA * normal;
+        points[c].onB -= marginB * normal;
+        points[c].depth += marginA + marginB;
+    }
+    reducePoints(points, &count, normal);
+    copy(points, points + count, manifold->points);
+    manifold->count = count;
+}
+
+bool contactManifold(Collider3D *a, Collider3D *b, float epsilon, ContactManifold3D *manifold, EpaScratch *scratch) {
+    *manifold = ContactManifold3D();
+    PenetrationResult penetration;
+    bool overlap = scratch ? epaPenetration(a, b, epsilon, &penetration, scratch) :
+                   epaPenetration(a, b, epsilon, &penetration);
+    manifold->supportCalls = penetration.supportCalls;
+    if (!overlap) return false;
+    buildManifold(a, b, penetration, epsilon, manifold);
+    return true;
+}
+
+const ContactManifold3D *ManifoldCache3D::update(uint64_t key, TransformCollider3D *a, TransformCollider3D *b,
+                                                 ManifoldStats *stats) {
+    ManifoldStats ignored;
+    if (!stats) stats = &ignored;
+    stats->queries++;
+    mat3 toA = transpose(a->rotation);
+    vec3 position = toA * (b->position - a->position);
+
+    auto found = entries.find(key);
+    // The shift is cheaper to test than the turn, and when pairs move too fast to reuse it is usually the one to fail.
+    if (found != entries.end() && length(position - found->second.position) <= settings.maxShift) {
+        Entry &entry = found->second;
+        mat3 rotation = toA * b->rotation;
+        // The trace of the rotation between the poses is 1 + 2 cos of its angle.
+        float trace = 0;
+        for (int c = 0; c < 3; c++) trace += dot(entry.rotation[c], rotation[c]);
+        if (trace >= 1 + 2 * std::cos(settings.maxTurn)) {
+            ContactManifold3D &world = entry.world;
+            world.normal = a->rotation * entry.local.normal;
+            world.supportCalls = 0;
+            bool touching = false;
+            for (int c = 0; c < world.count; c++) {
+                ContactPoint3D &point = world.points[c];
+                point.onA = a->rotation * entry.local.points[c].onA + a->position;
+                point.onB = b->rotation * entry.local.points[c].onB + b->position;
+                point.depth = dot(point.onA - point.onB, world.normal);
+                touching |= point.depth >= -settings.epsilon;
+            }
+            // Once every point has come apart the pair may have separated, which only a new query can tell.
+            if (touching) {
+                entry.touched = true;
+                stats->reused++;
+                return &world;
+            }
+        }
+    }
+
+    ContactManifold3D world;
+    bool overlap = contactManifold(a, b, settings.epsilon, &world, &scratch);
+    stats->built++;
+    stats->supportCalls += world.supportCalls;
+    if (!overlap) {
+        if (found != entries.end()) entries.erase(found);
+        return nullptr;
+    }
+
+    Entry &entry = found != entries.end() ? found->second : entries[key];
+    entry.rotation = toA * b->rotation;
+    entry.position = position;
+    entry.world = world;
+    entry.local = world;
+    entry.local.normal = toA * world.normal;
+    mat3 toB = transpose(b->rotation);
+    for (int c = 0; c < world.count; c++) {
+        entry.local.points[c].onA = toA * (world.points[c].onA - a->position);
+        entry.local.points[c].onB = toB * (world.points[c].onB - b->position);
+    }
+    entry.touched = true;
+    return &entry.world;
+}
+
+void ManifoldCache3D::endFrame(ManifoldStats *stats) {
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.touched) {
+            it->second.touched = false;
+            ++it;
+        } else {
+            it = entries.erase(it);
+            if (stats) stats->evicted++;
+        }
+    }
+}
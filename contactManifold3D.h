@@ -0,0 +1,93 @@
+//
+// Contact manifolds of up to four points for overlapping colliders, and a cache keeping them between frames.
+//
+
+#ifndef MINKOWSKIHULL3D_CONTACTMANIFOLD3D_H
+#define MINKOWSKIHULL3D_CONTACTMANIFOLD3D_H
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "epa3D.h"
+
+const int kMaxContactPoints = 4;
+
+struct ContactPoint3D {
+    glm::vec3 onA, onB; // onA - onB is depth along the reference face's normal, which is within tolerance of normal
+    float depth; // negative for points that are slightly apart, within the manifold's tolerance
+};
+
+struct ContactManifold3D {
+    glm::vec3 normal = glm::vec3(0); // the unit direction from a into b, as in PenetrationResult
+    ContactPoint3D points[kMaxContactPoints];
+    int count = 0;
+    int supportCalls = 0; // including the penetration query
+};
+
+// Probe directions lean this far from the contact normal, in radians, to find the features of each shape facing the
+// other. Faces tilted further than this from the normal are treated as the edge or vertex of them that sticks out.
+const float kManifoldTilt = 0.05f;
+
+// Builds the manifold of a and b from their penetration, which must have overlapped.
+// The feature of each shape facing the other is found by support queries in directions leaning around the normal, at
+// two tilts. The vertices of a flat feature are the same at both, while the points of a curved surface slide, so only
+// the vertices that stay are kept. Shapes with a margin are probed by their core and the margin added back, so rounded
+// boxes get faces too.
+// The feature with more vertices is the reference. The other is clipped against its sides, and the points within
+// epsilon of its plane or below it are kept, reduced to the four spanning the most area. A vertex on either side, or
+// an edge crossing an edge, makes the single point the penetration found.
+void buildManifold(Collider3D *a, Collider3D *b, const PenetrationResult &penetration, float epsilon,
+                   ContactManifold3D *manifold);
+
+// Finds the penetration of a and b by epaPenetration, and builds its manifold. Returns false, with no points, if they
+// don't overlap.
+bool contactManifold(Collider3D *a, Collider3D *b, float epsilon, ContactManifold3D *manifold,
+                     EpaScratch *scratch = nullptr);
+
+struct ManifoldStats {
+    size_t queries = 0;
+    size_t reused = 0; // manifolds moved along with their shapes, without any support queries
+    size_t built = 0;
+    size_t evicted = 0;
+    size_t supportCalls = 0;
+};
+
+// How far a pair may move relative to each other, since its manifold was built, for the manifold to be reused.
+struct ManifoldCacheSettings {
+    float epsilon = 1e-3f; // passed to contactManifold
+    float maxShift = 0.01f; // relative translation
+    float maxTurn = 0.01f; // relative rotation, in radians
+};
+
+// Manifolds of posed shapes, kept between frames by pair key, for instance ScenePair3D::key(). The points are kept in
+// each shape's own frame. While the pair barely moves relative to each other, its manifold is moved along with them
+// and its depths measured again, without any support queries. Otherwise, or once every point is more than epsilon
+// apart, it is built again, and dropped if the pair no longer overlaps. It only pays while most pairs move less than
+// maxShift a frame. A miss costs contactManifold plus a hash lookup, so when nearly every pair moves further it is no
+// faster than building every manifold.
+class ManifoldCache3D {
+public:
+    ManifoldCacheSettings settings;
+
+    // The manifold of a and b, or null if they don't overlap. Valid until the next call.
+    const ContactManifold3D *update(uint64_t key, TransformCollider3D *a, TransformCollider3D *b,
+                                    ManifoldStats *stats = nullptr);
+    // Drops the pairs that weren't updated since the last call, which have stopped touching or left the broadphase.
+    void endFrame(ManifoldStats *stats = nullptr);
+    size_t size() const { return entries.size(); }
+    void clear() { entries.clear(); }
+
+private:
+    struct Entry {
+        ContactManifold3D local; // onA and the normal in a's frame, onB in b's
+        glm::mat3 rotation; // b's rotation and position in a's frame when the manifold was built
+        glm::vec3 position;
+        ContactManifold3D world;
+        bool touched;
+    };
+
+    std::unordered_map<uint64_t, Entry> entries;
+    EpaScratch scratch;
+};
+
+#endif //MINKOWSKIHULL3D_CONTACTMANIFOLD3D_H
@@ -0,0 +1,210 @@
+//
+// Penetration depth of overlapping colliders by EPA, on SurfaceState's triangle mesh.
+//
+
+#include <algorithm>
+#include <vector>
+
+#include "epa3D.h"
+
+using namespace std;
+using namespace glm;
+
+// Points closer than this fraction of the simplex's size to its span don't add a dimension to it.
+static const float kEpaFlatTolerance = 1e-6f;
+
+static bool current(SurfaceState &state, const EpaFace &entry) {
+    const Triangle &tri = state.triangles[entry.triangle];
+    for (int k = 0; k < 3; k++) {
+        if (tri.edges[k].vertex != entry.vertices[k]) return false;
+    }
+    return true;
+}
+
+static void pushFace(SurfaceState &state, uint16_t triangle, vector<EpaFace> &faces) {
+    const Triangle &tri = state.triangles[triangle];
+    vec3 a = state.points[tri.edges[0].vertex];
+    vec3 b = state.points[tri.edges[1].vertex];
+    vec3 c = state.points[tri.edges[2].vertex];
+    if (cross(c - b, a - b) == vec3(0)) return; // slivers left by flips have no plane, and their neighbors cover them
+
+    // Distances to the face itself rather than its plane, since the planes of thin faces are poorly rounded.
+    GjkSimplex face;
+    face.points[0] = a;
+    face.points[1] = b;
+    face.points[2] = c;
+    face.count = 3;
+    EpaFace entry;
+    gjkSolveSimplex(face, &entry.closest);
+    entry.distance = length(entry.closest);
+    entry.triangle = triangle;
+    for (int k = 0; k < 3; k++) entry.vertices[k] = tri.edges[k].vertex;
+    faces.push_back(entry);
+    push_heap(faces.begin(), faces.end());
+}
+
+static vec3 faceNormal(SurfaceState &state, const EpaFace &entry) {
+    vec3 a = state.points[entry.vertices[0]], b = state.points[entry.vertices[1]], c = state.points[entry.vertices[2]];
+    return normalize(cross(c - b, a - b));
+}
+
+// Adds the support in direction to the simplex, and keeps it only if it lies further than the tolerance along
+// direction from the simplex's first point.
+static bool tryDirection(Collider3D *a, Collider3D *b, vec3 direction, GjkSimplex &simplex, GjkStats *stats) {
+    gjkAddSupport(a, b, direction, simplex, stats);
+    float scale = 0;
+    for (int c = 0; c < simplex.count; c++) scale = std::max(scale, length(simplex.points[c]));
+    vec3 unit = normalize(direction);
+    if (std::abs(dot(simplex.points[simplex.count - 1] - simplex.points[0], unit)) > kEpaFlatTolerance * scale) {
+        return true;
+    }
+    simplex.count--;
+    return false;
+}
+
+// GJK stops as soon as the origin is on its simplex, which may be a point, segment or triangle. EPA needs a
+// tetrahedron, so the simplex is grown by supports in directions out of its span. Returns false if the shape is flat.
+static bool growTetrahedron(Collider3D *a, Collider3D *b, GjkSimplex &simplex, GjkStats *stats) {
+    static const vec3 axes[3] = {vec3(1, 0, 0), vec3(0, 1, 0), vec3(0, 0, 1)};
+    if (simplex.count == 1) {
+        for (int c = 0; c < 6 && simplex.count == 1; c++) {
+            tryDirection(a, b, c < 3 ? axes[c] : -axes[c - 3], simplex, stats);
+        }
+    }
+    if (simplex.count == 2) {
+        vec3 line = simplex.points[1] - simplex.points[0];
+        vec3 axis = axes[0];
+        for (const vec3 &other : axes) {
+            if (std::abs(dot(other, line)) < std::abs(dot(axis, line))) axis = other;
+        }
+        vec3 u = normalize(cross(line, axis)), v = normalize(cross(line, u));
+        const vec3 directions[6] = {u, -u, v, -v, u + v, -u - v};
+        for (int c = 0; c < 6 && simplex.count == 2; c++) {
+            // Measured from the line rather than from a point on it.
+            vec3 off = directions[c] - line * (dot(directions[c], line) / dot(line, line));
+            tryDirection(a, b, off, simplex, stats);
+        }
+    }
+    if (simplex.count == 3) {
+        vec3 normal = cross(simplex.points[1] - simplex.points[0], simplex.points[2] - simplex.points[0]);
+        if (normal != vec3(0) && !tryDirection(a, b, normal, simplex, stats)) tryDirection(a, b, -normal, simplex, stats);
+    }
+    if (simplex.count < 4) return false;
+    vec3 p0 = simplex.points[0];
+    return dot(cross(simplex.points[1] - p0, simplex.points[2] - p0), simplex.points[3] - p0) != 0;
+}
+
+// Seeds state with the tetrahedron, its faces wound counterclockwise seen from outside like SurfaceState's.
+static void seedTetrahedron(const GjkSimplex &simplex, SurfaceState &state, vector<vec3> &onA, vector<vec3> &onB) {
+    int order[4] = {0, 1, 2, 3};
+    vec3 p0 = simplex.points[0];
+    if (dot(cross(simplex.points[1] - p0, simplex.points[2] - p0), simplex.points[3] - p0) > 0) swap(order[1], order[2]);
+    for (int index : order) {
+        state.points.push_back(simplex.points[index]);
+        onA.push_back(simplex.onA[index]);
+        onB.push_back(simplex.onB[index]);
+    }
+
+    static const uint16_t faces[4][3] = {{0, 1, 2}, {0, 3, 1}, {0, 2, 3}, {1, 3, 2}};
+    state.triangles.resize(4);
+    for (int f = 0; f < 4; f++) {
+        state.triangles[f].flags = 0;
+        for (int k = 0; k < 3; k++) state.triangles[f].edges[k].vertex = faces[f][k];
+    }
+    // Every edge runs from its vertex to the next one, and its opposite runs back.
+    for (int f = 0; f < 4; f++) {
+        for (int k = 0; k < 3; k++) {
+            for (int g = 0; g < 4; g++) {
+                for (int l = 0; l < 3; l++) {
+                    if (faces[g][l] == faces[f][(k + 1) % 3] && faces[g][(l + 1) % 3] == faces[f][k]) {
+                        state.triangles[f].edges[k].opposite = uint16_t(g * 4 + 1 + l);
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool epaPenetration(Collider3D *a, Collider3D *b, float epsilon, PenetrationResult *result) {
+    EpaScratch scratch;
+    return epaPenetration(a, b, epsilon, result, &scratch);
+}
+
+bool epaPenetration(Collider3D *a, Collider3D *b, float epsilon, PenetrationResult *result, EpaScratch *scratch) {
+    *result = PenetrationResult();
+    GjkSimplex simplex;
+    GjkStats stats;
+    if (!gjkIntersect(a, b, &simplex, &stats)) {
+        result->supportCalls = stats.supportCalls;
+        return false;
+    }
+    if (!growTetrahedron(a, b, simplex, &stats)) {
+        result->witnessA = simplex.onA[0];
+        result->witnessB = simplex.onB[0];
+        result->supportCalls = stats.supportCalls;
+        return true;
+    }
+
+    // The mesh only holds the points of a - b, so the supports of a and b that make them are kept alongside, in onA
+    // and onB.
+    SurfaceState &state = scratch->state;
+    state.object = nullptr;
+    state.epsilon = epsilon;
+    state.current = 0;
+    state.points.clear();
+    state.triangles.clear();
+    vector<vec3> &onA = scratch->onA, &onB = scratch->onB;
+    onA.clear();
+    onB.clear();
+    seedTetrahedron(simplex, state, onA, onB);
+    vector<uint16_t> &changed = scratch->changed;
+    state.changed = &changed;
+
+    vector<EpaFace> &faces = scratch->faces;
+    faces.clear();
+    for (uint16_t t = 0; t < 4; t++) pushFace(state, t, faces);
+
+    EpaFace closest = faces.front();
+    while (!faces.empty()) {
+        pop_heap(faces.begin(), faces.end());
+        EpaFace entry = faces.back();
+        faces.pop_back();
+        if (!current(state, entry)) continue;
+        closest = entry;
+        if (result->iterations >= kEpaMaxIterations) break;
+
+        // Expanded along the normal, like SurfaceState does, so the support is never behind the face.
+        vec3 normal = faceNormal(state, entry);
+        GjkSimplex probe;
+        gjkAddSupport(a, b, normal, probe, &stats);
+        // The shape reaches no further than epsilon past the closest face, so neither does its closest surface point.
+        if (dot(normal, probe.points[0] - state.points[entry.vertices[0]]) <= epsilon) break;
+
+        result->iterations++;
+        onA.push_back(probe.onA[0]);
+        onB.push_back(probe.onB[0]);
+        changed.clear();
+        state.split(entry.triangle, probe.points[0]);
+        for (uint16_t t : changed) pushFace(state, t, faces);
+    }
+
+    // The weights of the closest point pick the witnesses out of the supports of the face's vertices.
+    GjkSimplex face;
+    for (int k = 0; k < 3; k++) {
+        face.points[k] = state.points[closest.vertices[k]];
+        face.onA[k] = onA[closest.vertices[k]];
+        face.onB[k] = onB[closest.vertices[k]];
+    }
+    face.count = 3;
+    vec3 point;
+    gjkSolveSimplex(face, &point);
+    for (int k = 0; k < face.count; k++) {
+        result->witnessA += face.weights[k] * face.onA[k];
+        result->witnessB += face.weights[k] * face.onB[k];
+    }
+    result->depth = closest.distance;
+    float scale = std::max(length(state.points[closest.vertices[0]]), length(state.points[closest.vertices[1]]));
+    result->normal = closest.distance > kEpaFlatTolerance * scale ? point / closest.distance : faceNormal(state, closest);
+    result->supportCalls = stats.supportCalls;
+    return true;
+}
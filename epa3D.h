@@ -0,0 +1,51 @@
+//
+// Penetration depth of overlapping colliders by EPA, on SurfaceState's triangle mesh.
+//
+
+#ifndef MINKOWSKIHULL3D_EPA3D_H
+#define MINKOWSKIHULL3D_EPA3D_H
+
+#include "gjk3D.h"
+
+struct PenetrationResult {
+    float depth = 0;
+    // The unit direction from a into b. Moving a by -depth * normal, or b by depth * normal, leaves them touching.
+    glm::vec3 normal = glm::vec3(0);
+    // The deepest point of a inside b, and of b inside a, so witnessA - witnessB == depth * normal.
+    glm::vec3 witnessA = glm::vec3(0), witnessB = glm::vec3(0);
+    int iterations = 0; // faces expanded
+    int supportCalls = 0; // including the GJK query before
+};
+
+// A face on EPA's queue, closest first.
+struct EpaFace {
+    float distance;
+    glm::vec3 closest; // the point of the face closest to the origin
+    uint16_t triangle;
+    uint16_t vertices[3]; // the entry is stale once the triangle no longer has these vertices
+
+    bool operator<(const EpaFace &other) const { return distance > other.distance; }
+};
+
+// The buffers of a penetration query. Passing the same scratch to many queries reuses them, so a thread running a
+// batch stops allocating once they have grown. Scratch never changes a result.
+struct EpaScratch {
+    SurfaceState state;
+    std::vector<glm::vec3> onA, onB; // the supports of a and b making each point of the mesh
+    std::vector<uint16_t> changed;
+    std::vector<EpaFace> faces; // a heap
+};
+
+// EPA gives up after expanding this many faces, well within SurfaceState's 16 bit indices, and answers with the
+// closest face it has.
+const int kEpaMaxIterations = 256;
+
+// The smallest translation that separates a and b, found by expanding a polytope inside a - b from the simplex GJK
+// stopped with. Only the face closest to the origin is ever expanded, until the shape is within epsilon of it, so the
+// depth is at most epsilon too small. Returns false, leaving result's depth at 0, if the shapes don't overlap.
+// Shapes that only touch overlap with a depth of 0. If their difference is flat, the normal is 0 too.
+// b can be null, for the depth of the origin inside a alone.
+bool epaPenetration(Collider3D *a, Collider3D *b, float epsilon, PenetrationResult *result);
+bool epaPenetration(Collider3D *a, Collider3D *b, float epsilon, PenetrationResult *result, EpaScratch *scratch);
+
+#endif //MINKOWSKIHULL3D_EPA3D_H
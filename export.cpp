@@ -0,0 +1,49 @@
+//
+// Headless tool that hulls a config and writes the result as a hull file.
+// Usage: MinkowskiHull3DExport <config> <output> [planes] [adjacency]
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "hull3D.h"
+#include "bakedHull3D.h"
+#include "hullFile3D.h"
+#include "loader.h"
+#include "colliderArena.h"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        printf("Usage: %s <config> <output> [planes] [adjacency]\n", argv[0]);
+        return 2;
+    }
+    uint32_t sections = 0;
+    for (int c = 3; c < argc; c++) {
+        if (strcmp(argv[c], "planes") == 0) sections |= HULL_FILE_PLANES;
+        else if (strcmp(argv[c], "adjacency") == 0) sections |= HULL_FILE_ADJACENCY;
+        else {
+            printf("Unknown section '%s'.\n", argv[c]);
+            return 2;
+        }
+    }
+
+    ColliderArena colliders;
+    SurfaceState state;
+    if (!load(argv[1], &state, &colliders)) {
+        printf("Failed to load %s.\n", argv[1]);
+        return 1;
+    }
+    chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+    if (!finishHull(&state)) {
+        printf("The hull is too detailed for epsilon %f.\n", state.epsilon);
+        return 1;
+    }
+    double millis = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+    if (!writeHullFile(argv[2], state, sections)) return 1;
+    printf("Wrote %d points and %d triangles to %s, hulled in %.2fms.\n",
+           int(state.points.size()), int(state.triangles.size()), argv[2], millis);
+    return 0;
+}
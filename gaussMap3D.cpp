@@ -0,0 +1,347 @@
+//
+// Exact Minkowski sums of polytopes, by merging their Gauss maps.
+//
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "gaussMap3D.h"
+#include "quickHull3D.h"
+#include "clusteredPoints3D.h"
+#include "bakedHull3D.h"
+#include "pointsFile3D.h"
+
+using namespace std;
+using namespace glm;
+
+// The Gauss map of a polytope maps every face to its normal, every edge to the arc between the normals of its two
+// faces, and every vertex to the region of directions for which it is the support.
+// The Gauss map of A + B is the overlay of the maps of A and B. Its points are the face normals of A, the face normals
+// of B, and the crossings of an arc of A with an arc of B. Walking the arcs of A across the map of B finds every
+// crossing in time proportional to the output.
+struct Arc {
+    uint32_t left, right; // faces
+    uint32_t from, to; // vertices of the edge
+};
+
+struct GaussMap {
+    vector<vec3> points;
+    vector<vector<uint32_t>> neighbors;
+    vector<vec3> normals;
+    vector<Arc> arcs;
+    float tolerance; // support values closer than this are considered equal
+};
+
+static const float kRelativeTolerance = 1e-5f;
+
+static float toleranceFor(const vector<vec3> &points) {
+    float scale = 0;
+    for (const vec3 &pt : points) {
+        scale = std::max(scale, std::max(std::abs(pt.x), std::max(std::abs(pt.y), std::abs(pt.z))));
+    }
+    return kRelativeTolerance * std::max(scale, 1e-6f);
+}
+
+static bool makeGaussMap(const PolytopeHull3D &hull, GaussMap &map) {
+    map.points = hull.points;
+    map.normals = hull.normals;
+    map.neighbors.clear();
+    map.neighbors.resize(hull.points.size());
+    map.arcs.clear();
+    map.tolerance = toleranceFor(hull.points);
+
+    if (hull.faces.empty()) return hull.points.size() == 1;
+
+    unordered_map<uint64_t, uint32_t> edgeFaces;
+    for (uint32_t f = 0, n = hull.faces.size(); f < n; f++) {
+        const vector<uint32_t> &face = hull.faces[f];
+        for (size_t c = 0, m = face.size(); c < m; c++) {
+            uint64_t key = uint64_t(face[c]) << 32 | face[(c + 1) % m];
+            if (!edgeFaces.insert(make_pair(key, f)).second) return false; // not a manifold
+        }
+    }
+
+    for (uint32_t f = 0, n = hull.faces.size(); f < n; f++) {
+        const vector<uint32_t> &face = hull.faces[f];
+        for (size_t c = 0, m = face.size(); c < m; c++) {
+            uint32_t from = face[c];
+            uint32_t to = face[(c + 1) % m];
+            auto opposite = edgeFaces.find(uint64_t(to) << 32 | from);
+            if (opposite == edgeFaces.end()) return false; // has a hole
+            if (from > to) continue; // each edge is recorded from one side only
+
+            Arc arc;
+            arc.left = f;
+            arc.right = opposite->second;
+            arc.from = from;
+            arc.to = to;
+            map.arcs.push_back(arc);
+            map.neighbors[from].push_back(to);
+            map.neighbors[to].push_back(from);
+        }
+    }
+
+    // Euler's formula catches faces that overlap without sharing edges.
+    return map.points.size() - map.arcs.size() + hull.faces.size() == 2;
+}
+
+// Collects the vertices of a + sign * b, as pairs of vertices of a and b.
+struct Merger {
+    const GaussMap &a;
+    const GaussMap &b;
+    float sign;
+
+    uint32_t hintA = 0;
+    uint32_t hintB = 0;
+    vector<uint32_t> stampsA, stampsB;
+    uint32_t stamp = 0;
+    vector<uint32_t> setA, setB;
+    vector<uint32_t> queue;
+
+    vector<uint64_t> candidates; // a index * b size + b index, with duplicates
+
+    Merger(const GaussMap &a, const GaussMap &b, float sign) :
+            a(a), b(b), sign(sign), stampsA(a.points.size()), stampsB(b.points.size()) {}
+
+    // Hill climbs to the support of map scaled by sign. This always finds the global maximum because the map is convex.
+    static uint32_t climb(const GaussMap &map, float sign, vec3 dir, uint32_t start) {
+        uint32_t vert = start;
+        float best = sign * dot(map.points[vert], dir);
+        bool moved = true;
+        while (moved) {
+            moved = false;
+            for (uint32_t next : map.neighbors[vert]) {
+                float d = sign * dot(map.points[next], dir);
+                if (d > best) {
+                    best = d;
+                    vert = next;
+                    moved = true;
+                }
+            }
+        }
+        return vert;
+    }
+
+    // Finds all vertices within tolerance of the support plane. They are connected, so a flood fill suffices.
+    void supportSet(const GaussMap &map, float sign, vec3 dir, uint32_t &hint, vector<uint32_t> &stamps, vector<uint32_t> &out) {
+        hint = climb(map, sign, dir, hint);
+        float limit = sign * dot(map.points[hint], dir) - map.tolerance;
+        out.clear();
+        queue.clear();
+        queue.push_back(hint);
+        stamps[hint] = stamp;
+        while (!queue.empty()) {
+            uint32_t vert = queue.back();
+            queue.pop_back();
+            out.push_back(vert);
+            for (uint32_t next : map.neighbors[vert]) {
+                if (stamps[next] == stamp) continue;
+                stamps[next] = stamp;
+                if (sign * dot(map.points[next], dir) >= limit) queue.push_back(next);
+            }
+        }
+    }
+
+    // Adds the vertices of the sum that support dir. They are among the sums of the vertices that support dir in a
+    // and b. The support sets include everything within tolerance, so the candidates err on the side of too many.
+    void addCandidates(vec3 dir) {
+        dir = normalize(dir);
+        stamp++;
+        supportSet(a, 1, dir, hintA, stampsA, setA);
+        supportSet(b, sign, dir, hintB, stampsB, setB);
+        for (uint32_t ia : setA) {
+            for (uint32_t ib : setB) {
+                candidates.push_back(uint64_t(ia) * b.points.size() + ib);
+            }
+        }
+    }
+
+    // Walks the arc of a from its left normal to its right normal through the map of b.
+    // The direction is parameterized as left + t * (right - left), so the support value of every edge is linear in t.
+    void walkArc(const Arc &arc) {
+        vec3 left = a.normals[arc.left];
+        vec3 delta = a.normals[arc.right] - left;
+        vec3 edgeA = a.points[arc.to] - a.points[arc.from];
+
+        uint32_t vert = hintB = climb(b, sign, left, hintB);
+        float t = 0;
+        for (size_t guard = 0, n = b.points.size(); guard < n; guard++) {
+            vec3 base = sign * b.points[vert];
+            float bestT = 1;
+            uint32_t next = vert;
+            for (uint32_t other : b.neighbors[vert]) {
+                vec3 edgeB = sign * b.points[other] - base;
+                float slope = dot(edgeB, delta);
+                if (slope <= 0) continue;
+                float crossT = std::max(t, -dot(edgeB, left) / slope);
+                if (crossT < bestT) {
+                    bestT = crossT;
+                    next = other;
+                }
+            }
+            if (next == vert) break;
+
+            // The exact direction of the crossing is perpendicular to both edges.
+            vec3 dir = left + bestT * delta;
+            vec3 edgeB = sign * b.points[next] - base;
+            vec3 normal = cross(edgeA, edgeB);
+            if (dot(normal, normal) > 1e-6f * dot(edgeA, edgeA) * dot(edgeB, edgeB)) {
+                dir = dot(normal, dir) < 0 ? -normal : normal;
+            }
+            addCandidates(dir);
+
+            vert = next;
+            t = bestT;
+        }
+    }
+
+    void merge() {
+        for (const vec3 &normal : a.normals) addCandidates(normal);
+        for (const vec3 &normal : b.normals) addCandidates(sign * normal);
+        for (const Arc &arc : a.arcs) walkArc(arc);
+    }
+};
+
+// The candidates are hulled to get the faces, since deciding which of them are coplanar is where the precision
+// problems are. Only a few candidates aren't vertices, so this is still proportional to the output.
+static bool merge(const GaussMap &a, const GaussMap &b, float sign, PolytopeHull3D &out) {
+    if (a.normals.empty() && b.normals.empty()) {
+        out.points.assign(1, a.points[0] + sign * b.points[0]);
+        out.faces.clear();
+        out.normals.clear();
+        return true;
+    }
+
+    Merger merger(a, b, sign);
+    merger.merge();
+    vector<uint64_t> &ids = merger.candidates;
+    sort(ids.begin(), ids.end());
+    ids.erase(unique(ids.begin(), ids.end()), ids.end());
+
+    vector<vec3> points;
+    points.reserve(ids.size());
+    for (uint64_t id : ids) {
+        points.push_back(a.points[id / b.points.size()] + sign * b.points[id % b.points.size()]);
+    }
+    return quickHull(points, &out);
+}
+
+static bool hullOf(Collider3D *collider, bool coreOnly, PolytopeHull3D &out) {
+    if (SharedCollider3D *shared = dynamic_cast<SharedCollider3D *>(collider)) {
+        return hullOf(shared->inner, coreOnly, out);
+    }
+
+    if (PointCollider3D *point = dynamic_cast<PointCollider3D *>(collider)) {
+        out.points.assign(1, point->point);
+        out.faces.clear();
+        out.normals.clear();
+        return true;
+    }
+
+    if (coreOnly && dynamic_cast<SphereCollider3D *>(collider)) {
+        out.points.assign(1, vec3(0));
+        out.faces.clear();
+        out.normals.clear();
+        return true;
+    }
+
+    PointHullCollider3D *points = dynamic_cast<PointHullCollider3D *>(collider);
+    ClusteredPointsCollider3D *clustered = dynamic_cast<ClusteredPointsCollider3D *>(collider);
+    PointViewCollider3D *view = dynamic_cast<PointViewCollider3D *>(collider);
+    if (points || clustered || view) {
+        vector<vec3> leaf = points ? points->points() : clustered ? clustered->points() : view->points();
+        if (quickHull(leaf, &out)) return true;
+        // Flat, which is fine only if it's a single point.
+        for (const vec3 &pt : leaf) {
+            if (pt != leaf[0]) return false;
+        }
+        out.points.assign(1, leaf[0]);
+        out.faces.clear();
+        out.normals.clear();
+        return true;
+    }
+
+    if (BakedHullCollider3D *baked = dynamic_cast<BakedHullCollider3D *>(collider)) {
+        if (!coreOnly && baked->sphereMargin > 0) return false;
+        return quickHull(baked->vertices, &out);
+    }
+
+    // The hull of a swept shape is the hull of its vertices at both ends of the sweep.
+    if (SweptCollider3D *swept = dynamic_cast<SweptCollider3D *>(collider)) {
+        PolytopeHull3D inner;
+        if (!hullOf(swept->inner, coreOnly, inner)) return false;
+        vector<vec3> ends = inner.points;
+        for (const vec3 &pt : inner.points) ends.push_back(pt + swept->translation);
+        return quickHull(ends, &out);
+    }
+
+    Collider3D *a, *b;
+    float sign;
+    if (AddCollider3D *add = dynamic_cast<AddCollider3D *>(collider)) {
+        a = add->a;
+        b = add->b;
+        sign = 1;
+    } else if (SubCollider3D *sub = dynamic_cast<SubCollider3D *>(collider)) {
+        a = sub->a;
+        b = sub->b;
+        sign = -1;
+    } else {
+        return false;
+    }
+
+    PolytopeHull3D hullA, hullB;
+    GaussMap mapA, mapB;
+    return hullOf(a, coreOnly, hullA) && makeGaussMap(hullA, mapA) &&
+           hullOf(b, coreOnly, hullB) && makeGaussMap(hullB, mapB) &&
+           merge(mapA, mapB, sign, out);
+}
+
+bool buildExactHull(Collider3D *object, bool coreOnly, PolytopeHull3D *hull) {
+    GaussMap check;
+    return hullOf(object, coreOnly, *hull) && makeGaussMap(*hull, check);
+}
+
+bool buildExactHull(SurfaceState *state) {
+    PolytopeHull3D hull;
+    if (!buildExactHull(state->object, state->splitMargin, &hull)) return false;
+
+    size_t numTriangles = 0;
+    for (const vector<uint32_t> &face : hull.faces) numTriangles += face.size() - 2;
+    if (hull.points.size() > 65535 || numTriangles * 4 > 65535) return false; // too big to index
+
+    state->points = hull.points;
+    state->triangles.clear();
+    for (const vector<uint32_t> &face : hull.faces) {
+        for (size_t c = 1; c + 1 < face.size(); c++) {
+            state->triangles.emplace_back();
+            Triangle &tri = state->triangles.back();
+            tri.flags = 0;
+            tri.edges[0].vertex = uint16_t(face[0]);
+            tri.edges[1].vertex = uint16_t(face[c]);
+            tri.edges[2].vertex = uint16_t(face[c + 1]);
+        }
+    }
+
+    // Link up the half edges. The hull is a closed manifold, so every edge has an opposite.
+    unordered_map<uint32_t, uint16_t> halfEdges;
+    for (uint16_t t = 0, n = uint16_t(state->triangles.size()); t < n; t++) {
+        Triangle &tri = state->triangles[t];
+        for (int c = 0; c < 3; c++) {
+            uint32_t from = tri.edges[c].vertex;
+            uint32_t to = tri.edges[(c + 1) % 3].vertex;
+            halfEdges[from << 16 | to] = uint16_t(t * 4 + c + 1);
+        }
+    }
+    for (Triangle &tri : state->triangles) {
+        for (int c = 0; c < 3; c++) {
+            uint32_t from = tri.edges[c].vertex;
+            uint32_t to = tri.edges[(c + 1) % 3].vertex;
+            tri.edges[c].opposite = halfEdges[to << 16 | from];
+        }
+    }
+
+    state->margin = state->splitMargin ? state->object->margin() : 0;
+    state->epsilon = 0;
+    state->current = uint16_t(state->triangles.size());
+    return true;
+}
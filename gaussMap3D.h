@@ -0,0 +1,21 @@
+//
+// Exact Minkowski sums of polytopes, by merging their Gauss maps.
+//
+
+#ifndef MINKOWSKIHULL3D_GAUSSMAP3D_H
+#define MINKOWSKIHULL3D_GAUSSMAP3D_H
+
+#include "hull3D.h"
+
+// Computes the exact hull of a collider tree made only of points colliders, point colliders, add and sub.
+// If coreOnly is set, spheres are accepted too and contribute their core (see Collider3D::margin).
+// Returns false if the tree contains anything else, if a points collider is flat, or if the result can't be
+// built robustly. In that case the caller should fall back to SurfaceState.
+bool buildExactHull(Collider3D *object, bool coreOnly, PolytopeHull3D *hull);
+
+// Builds the exact hull of state->object and stores it in state as a finished triangulation.
+// Respects state->splitMargin. Sets state->epsilon to 0, since the hull is exact, so baked and cached hulls record the
+// same epsilon whichever path built them. Returns false, leaving state untouched, if the exact hull can't be used.
+bool buildExactHull(SurfaceState *state);
+
+#endif //MINKOWSKIHULL3D_GAUSSMAP3D_H
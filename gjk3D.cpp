@@ -0,0 +1,381 @@
+//
+// Queries on colliders by GJK, which only needs their support functions, so no hull is ever built.
+//
+
+#include <algorithm>
+
+#include "gjk3D.h"
+#include "workerPool.h"
+
+using namespace std;
+using namespace glm;
+
+// Distances below this fraction of the simplex's size are as good as zero in float.
+static const float kGjkRelativeTolerance = 1e-5f;
+
+// Adds the support of a - b in direction to the simplex, or of a alone if b is null.
+void gjkAddSupport(Collider3D *a, Collider3D *b, vec3 direction, GjkSimplex &simplex, GjkStats *stats) {
+    if (stats) stats->supportCalls++;
+    int c = simplex.count++;
+    simplex.onA[c] = a->findSupport(direction);
+    simplex.onB[c] = b ? b->findSupport(-direction) : vec3(0);
+    simplex.points[c] = simplex.onA[c] - simplex.onB[c];
+    simplex.directions[c] = direction;
+}
+
+// Reduces the simplex to the given points, with the given weights, and returns the point they weigh to.
+static vec3 keep(GjkSimplex &simplex, int i, float wi, int j = -1, float wj = 0, int k = -1, float wk = 0) {
+    const int order[3] = {i, j, k};
+    const float weights[3] = {wi, wj, wk};
+    GjkSimplex kept;
+    vec3 closest = vec3(0);
+    for (int c = 0; c < 3 && order[c] >= 0; c++) {
+        kept.points[c] = simplex.points[order[c]];
+        kept.onA[c] = simplex.onA[order[c]];
+        kept.onB[c] = simplex.onB[order[c]];
+        kept.directions[c] = simplex.directions[order[c]];
+        kept.weights[c] = weights[c];
+        kept.count++;
+        closest += weights[c] * kept.points[c];
+    }
+    simplex = kept;
+    return closest;
+}
+
+// The closest point to the origin on a segment, reducing the simplex to the vertex that holds it if it is one.
+static vec3 solveSegment(GjkSimplex &simplex) {
+    vec3 a = simplex.points[0], b = simplex.points[1];
+    vec3 ab = b - a;
+    float t = -dot(a, ab);
+    if (t <= 0) return keep(simplex, 0, 1);
+    float length2 = dot(ab, ab);
+    if (t >= length2) return keep(simplex, 1, 1);
+    float u = t / length2;
+    return keep(simplex, 0, 1 - u, 1, u);
+}
+
+// The closest point to the origin on a triangle, by its Voronoi regions, reducing the simplex to the feature holding it.
+static vec3 solveTriangle(GjkSimplex &simplex) {
+    vec3 a = simplex.points[0], b = simplex.points[1], c = simplex.points[2];
+    vec3 ab = b - a, ac = c - a;
+
+    float d1 = -dot(ab, a), d2 = -dot(ac, a);
+    if (d1 <= 0 && d2 <= 0) return keep(simplex, 0, 1);
+    float d3 = -dot(ab, b), d4 = -dot(ac, b);
+    if (d3 >= 0 && d4 <= d3) return keep(simplex, 1, 1);
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+        float u = d1 / (d1 - d3);
+        return keep(simplex, 0, 1 - u, 1, u);
+    }
+    float d5 = -dot(ab, c), d6 = -dot(ac, c);
+    if (d6 >= 0 && d5 <= d6) return keep(simplex, 2, 1);
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+        float u = d2 / (d2 - d6);
+        return keep(simplex, 0, 1 - u, 2, u);
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) {
+        float u = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        return keep(simplex, 1, 1 - u, 2, u);
+    }
+    float sum = va + vb + vc;
+    if (!(sum > 0)) {
+        // Too thin to have an inside. The closest point is on its longest edge.
+        float ab2 = dot(ab, ab), ac2 = dot(ac, ac), bc2 = dot(c - b, c - b);
+        if (ab2 >= ac2 && ab2 >= bc2) keep(simplex, 0, 0, 1, 0);
+        else if (ac2 >= bc2) keep(simplex, 0, 0, 2, 0);
+        else keep(simplex, 1, 0, 2, 0);
+        return solveSegment(simplex);
+    }
+    // Inside the triangle. The products above cancel badly on slivers, which GJK keeps meeting on nearly flat or
+    // nearly touching shapes, so the point is found again by projecting the origin onto the plane, and weighed from
+    // the edges.
+    vec3 normal = cross(ab, ac);
+    float normal2 = dot(normal, normal);
+    if (!(normal2 > 0)) return keep(simplex, 0, va / sum, 1, vb / sum, 2, vc / sum);
+    vec3 closest = normal * (dot(normal, a) / normal2);
+    vec3 ap = closest - a;
+    float u = dot(cross(ap, ac), normal) / normal2, w = dot(cross(ab, ap), normal) / normal2;
+    keep(simplex, 0, 1 - u - w, 1, u, 2, w);
+    return closest;
+}
+
+// The closest point to the origin on a tetrahedron, reducing the simplex to the face holding it.
+// Returns false, keeping all four points, if the origin is inside.
+static bool solveTetrahedron(GjkSimplex &simplex, vec3 *closest) {
+    static const int faces[4][4] = {{0, 1, 2, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {1, 3, 2, 0}}; // three, then the other
+    GjkSimplex best;
+    float bestDistance = 0;
+    for (const int *face : faces) {
+        vec3 a = simplex.points[face[0]], b = simplex.points[face[1]], c = simplex.points[face[2]];
+        vec3 normal = cross(b - a, c - a);
+        float origin = -dot(normal, a), other = dot(normal, simplex.points[face[3]] - a);
+        // A flat tetrahedron has no inside, so every face is a candidate.
+        bool flat = std::abs(other) <= kGjkRelativeTolerance * length(normal) * length(simplex.points[face[3]] - a);
+        if (!flat && origin * other >= 0) continue;
+
+        GjkSimplex candidate = simplex;
+        keep(candidate, face[0], 0, face[1], 0, face[2], 0);
+        vec3 point = solveTriangle(candidate);
+        float distance = dot(point, point);
+        if (best.count == 0 || distance < bestDistance) {
+            best = candidate;
+            bestDistance = distance;
+            *closest = point;
+        }
+    }
+    if (best.count == 0) return false;
+    simplex = best;
+    return true;
+}
+
+bool gjkSolveSimplex(GjkSimplex &simplex, vec3 *closest) {
+    switch (simplex.count) {
+        case 1: *closest = keep(simplex, 0, 1); return true;
+        case 2: *closest = solveSegment(simplex); return true;
+        case 3: *closest = solveTriangle(simplex); return true;
+        default: return solveTetrahedron(simplex, closest);
+    }
+}
+
+bool gjkIntersect(Collider3D *a, Collider3D *b, GjkSimplex *simplex, GjkStats *stats) {
+    simplex->count = 0;
+    gjkAddSupport(a, b, vec3(1, 0, 0), *simplex, stats);
+    return gjkIntersectFrom(a, b, simplex, stats);
+}
+
+bool gjkIntersectFrom(Collider3D *a, Collider3D *b, GjkSimplex *simplex, GjkStats *stats) {
+    GjkSimplex &s = *simplex;
+    float scale = 0;
+    for (int c = 0; c < s.count; c++) scale = std::max(scale, dot(s.points[c], s.points[c]));
+    vec3 v;
+    if (!gjkSolveSimplex(s, &v)) return true;
+
+    for (int iteration = 0; iteration < kGjkMaxIterations; iteration++) {
+        float vv = dot(v, v);
+        if (vv <= kGjkRelativeTolerance * kGjkRelativeTolerance * scale) return true; // the origin is on the simplex
+
+        gjkAddSupport(a, b, -v, s, stats);
+        vec3 w = s.points[s.count - 1];
+        // Nothing in the shape is further along -v than w, and the origin is, so the plane through w separates them.
+        if (dot(w, v) > 0) return false;
+        scale = std::max(scale, dot(w, w));
+        for (int c = 0; c < s.count - 1; c++) {
+            if (s.points[c] == w) { // no progress, so v is as close as the shape gets
+                s.count--;
+                return true;
+            }
+        }
+
+        if (stats) stats->iterations++;
+        if (!gjkSolveSimplex(s, &v)) return true;
+    }
+    return true;
+}
+
+bool gjkContainsOrigin(Collider3D *shape, GjkStats *stats) {
+    GjkSimplex simplex;
+    return gjkIntersect(shape, nullptr, &simplex, stats);
+}
+
+bool gjkIntersect(Collider3D *a, Collider3D *b, GjkStats *stats) {
+    GjkSimplex simplex;
+    return gjkIntersect(a, b, &simplex, stats);
+}
+
+bool gjkDistance(Collider3D *a, Collider3D *b, DistanceResult *result, GjkSimplex *warmStart) {
+    *result = DistanceResult();
+    GjkStats stats;
+    GjkSimplex s;
+    if (warmStart) {
+        for (int c = 0; c < warmStart->count; c++) {
+            gjkAddSupport(a, b, warmStart->directions[c], s, &stats);
+            for (int d = 0; d < s.count - 1; d++) {
+                if (s.points[d] == s.points[s.count - 1]) {
+                    s.count--;
+                    break;
+                }
+            }
+        }
+    }
+    if (s.count == 0) gjkAddSupport(a, b, vec3(1, 0, 0), s, &stats);
+
+    vec3 v;
+    bool separated = gjkSolveSimplex(s, &v);
+    float scale = 0;
+    for (int c = 0; c < s.count; c++) scale = std::max(scale, dot(s.points[c], s.points[c]));
+
+    while (separated && result->iterations < kGjkMaxIterations) {
+        float vv = dot(v, v);
+        if (vv <= kGjkRelativeTolerance * kGjkRelativeTolerance * scale) {
+            separated = false; // the origin is on the simplex
+            break;
+        }
+
+        gjkAddSupport(a, b, -v, s, &stats);
+        vec3 w = s.points[s.count - 1];
+        scale = std::max(scale, dot(w, w));
+        // w is the furthest the shape reaches towards the origin along v. If that's barely past the simplex, no point
+        // of the shape is much closer than v.
+        bool converged = vv - dot(v, w) <= kGjkDistanceTolerance * vv;
+        for (int c = 0; c < s.count - 1 && !converged; c++) converged = s.points[c] == w;
+        if (converged) {
+            s.count--;
+            break;
+        }
+
+        result->iterations++;
+        GjkSimplex previous = s;
+        previous.count--;
+        vec3 closer;
+        if (!gjkSolveSimplex(s, &closer)) {
+            separated = false;
+            break;
+        }
+        // Rounding can make the solver step back. The last simplex is as close as this gets then.
+        if (dot(closer, closer) >= vv) {
+            s = previous;
+            break;
+        }
+        v = closer;
+    }
+
+    if (separated) {
+        for (int c = 0; c < s.count; c++) {
+            result->witnessA += s.weights[c] * s.onA[c];
+            result->witnessB += s.weights[c] * s.onB[c];
+        }
+        result->distance = length(v);
+    }
+    result->supportCalls = stats.supportCalls;
+    if (warmStart) *warmStart = s;
+    return separated;
+}
+
+// Casts the ray origin + t * translation, for t in [0, 1], against a - b, or a alone if b is null.
+// The simplex keeps the support points of the shape in onA and onB, and their offsets from the ray's current start x
+// in points, which are refreshed whenever x moves. v is the closest point of that to the origin, so it points from the
+// shape towards x.
+static bool castRay(Collider3D *a, Collider3D *b, vec3 origin, vec3 translation, RayHit *hit) {
+    *hit = RayHit();
+    GjkStats stats;
+    GjkSimplex s;
+    float t = 0;
+    vec3 x = origin, normal = vec3(0);
+    gjkAddSupport(a, b, translation == vec3(0) ? vec3(1, 0, 0) : -translation, s, &stats);
+    s.points[0] = x - s.points[0];
+    vec3 v = s.points[0];
+    float scale = dot(v, v);
+    bool inside = false;
+
+    while (hit->iterations < kGjkMaxIterations) {
+        if (dot(v, v) <= kGjkCastTolerance * kGjkCastTolerance * scale) {
+            inside = true; // x is on the shape, to within the tolerance
+            break;
+        }
+
+        gjkAddSupport(a, b, v, s, &stats);
+        int last = s.count - 1;
+        GjkSimplex newest = s;
+        keep(newest, last, 1);
+        bool repeated = false;
+        for (int c = 0; c < last && !repeated; c++) repeated = s.onA[c] == s.onA[last] && s.onB[c] == s.onB[last];
+        vec3 w = x - s.points[last];
+        float vw = dot(v, w);
+        if (vw > 0) {
+            // The plane through the support point separates x from the shape. Either the ray never crosses it, or x
+            // can move up to it, and no further, without reaching the shape.
+            float vr = dot(v, translation);
+            if (vr >= 0) break;
+            t -= vw / vr;
+            if (t > 1) break;
+            x = origin + t * translation;
+            normal = v;
+            // The tolerance follows x, so it isn't set by how far away the ray started.
+            scale = 0;
+            for (int c = 0; c < last; c++) {
+                s.points[c] = x - (s.onA[c] - s.onB[c]);
+                scale = std::max(scale, dot(s.points[c], s.points[c]));
+            }
+            w = x - s.points[last];
+        } else if (repeated) {
+            inside = true; // no point of the shape is closer to x than v, and it didn't separate them
+            break;
+        }
+        if (repeated) {
+            s.count--;
+        } else {
+            s.points[last] = w;
+            scale = std::max(scale, dot(w, w));
+        }
+
+        hit->iterations++;
+        vec3 closer;
+        if (!gjkSolveSimplex(s, &closer)) {
+            inside = true;
+            break;
+        }
+        // The new point should always bring the simplex closer. If rounding on a sliver of a simplex stopped it, start
+        // again from the new point alone.
+        if (vw <= 0 && dot(closer, closer) >= dot(v, v)) {
+            s = newest;
+            s.points[0] = closer = w;
+        }
+        v = closer;
+    }
+    // A ray still converging at the cap is within the shape's rounding of it.
+    if (hit->iterations == kGjkMaxIterations) inside = true;
+
+    hit->supportCalls = stats.supportCalls;
+    if (!inside) return false;
+    hit->fraction = t;
+    hit->normal = t > 0 ? normalize(normal) : vec3(0);
+    return true;
+}
+
+bool gjkRaycast(Collider3D *shape, vec3 origin, vec3 translation, RayHit *hit) {
+    return castRay(shape, nullptr, origin, translation, hit);
+}
+
+bool gjkShapeCast(Collider3D *a, vec3 translation, Collider3D *b, RayHit *hit) {
+    return castRay(b, a, vec3(0), translation, hit);
+}
+
+void RayBatch3D::add(vec3 origin, vec3 translation) {
+    originX.push_back(origin.x);
+    originY.push_back(origin.y);
+    originZ.push_back(origin.z);
+    translationX.push_back(translation.x);
+    translationY.push_back(translation.y);
+    translationZ.push_back(translation.z);
+}
+
+// Rays are handed to threads this many at a time, so each task is worth the scheduling.
+static const size_t kRayBlockSize = 64;
+
+void gjkRaycast(Collider3D *shape, const RayBatch3D &rays, RayBatchHits3D *hits) {
+    size_t count = rays.size();
+    hits->hit.resize(count);
+    hits->fraction.resize(count);
+    hits->normalX.resize(count);
+    hits->normalY.resize(count);
+    hits->normalZ.resize(count);
+    hits->iterations.resize(count);
+
+    size_t blocks = (count + kRayBlockSize - 1) / kRayBlockSize;
+    sharedWorkerPool().parallelFor(blocks, [&](size_t block) {
+        size_t end = std::min(count, (block + 1) * kRayBlockSize);
+        for (size_t c = block * kRayBlockSize; c < end; c++) {
+            RayHit hit;
+            hits->hit[c] = castRay(shape, nullptr, vec3(rays.originX[c], rays.originY[c], rays.originZ[c]),
+                                   vec3(rays.translationX[c], rays.translationY[c], rays.translationZ[c]), &hit);
+            hits->fraction[c] = hit.fraction;
+            hits->normalX[c] = hit.normal.x;
+            hits->normalY[c] = hit.normal.y;
+            hits->normalZ[c] = hit.normal.z;
+            hits->iterations[c] = hit.iterations;
+        }
+    });
+}
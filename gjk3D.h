@@ -0,0 +1,115 @@
+//
+// Queries on colliders by GJK, which only needs their support functions, so no hull is ever built.
+//
+
+#ifndef MINKOWSKIHULL3D_GJK3D_H
+#define MINKOWSKIHULL3D_GJK3D_H
+
+#include "hull3D.h"
+
+// Up to four support points of a shape, the vertices of the simplex GJK searches with. For a pair of shapes, the points
+// are of a - b, and the supports of a and b that make each of them are kept too.
+struct GjkSimplex {
+    glm::vec3 points[4];
+    glm::vec3 onA[4], onB[4]; // points[i] == onA[i] - onB[i]
+    glm::vec3 directions[4]; // the directions the points are supports in, to find them again after the shapes move
+    float weights[4]; // barycentric coordinates of the closest point to the origin, after gjkSolveSimplex
+    int count = 0;
+};
+
+struct GjkStats {
+    int iterations = 0; // simplex updates
+    int supportCalls = 0; // findSupport calls on the shape, or on each of the pair
+};
+
+// Queries give up after this many iterations. Polytopes converge in far fewer, but curved shapes only converge
+// geometrically, so a query that reaches the cap has its answer within the shape's rounding.
+const int kGjkMaxIterations = 64;
+
+// Adds the support of a - b in direction to the simplex, which must have room, or the support of a alone if b is null.
+void gjkAddSupport(Collider3D *a, Collider3D *b, glm::vec3 direction, GjkSimplex &simplex, GjkStats *stats = nullptr);
+
+// Reduces simplex to the smallest feature holding its closest point to the origin, which it returns, and sets the
+// weights of the remaining points. Returns false, keeping all four points, if the simplex is a tetrahedron enclosing
+// the origin. This is Johnson's sub-simplex solver, with the regions tested geometrically like Ericson's.
+bool gjkSolveSimplex(GjkSimplex &simplex, glm::vec3 *closest);
+
+// Whether the origin is inside shape. Usually decided after a handful of support calls: either a support point shows a
+// plane separating the origin from the shape, or a tetrahedron of support points encloses the origin.
+// Origins on the surface, or closer to it than the query can resolve, count as inside.
+bool gjkContainsOrigin(Collider3D *shape, GjkStats *stats = nullptr);
+
+// Whether a and b overlap, which is whether the origin is inside their difference. The same as gjkContainsOrigin on a
+// SubCollider3D of them, and touching counts as overlapping.
+bool gjkIntersect(Collider3D *a, Collider3D *b, GjkStats *stats = nullptr);
+
+// Same as gjkIntersect, and leaves the last simplex in simplex. If the shapes overlap, it encloses or touches the
+// origin, which makes it the starting point for a penetration query. b can be null to query a alone.
+bool gjkIntersect(Collider3D *a, Collider3D *b, GjkSimplex *simplex, GjkStats *stats = nullptr);
+
+// Same as gjkIntersect with a simplex, but searches on from the points already in it, which must be distinct supports
+// of a - b, for instance ones looked up again in the directions an earlier query found them.
+// Both leave a separating direction when the shapes don't overlap: the last point's, directions[count - 1], along which
+// no point of a - b reaches the origin.
+bool gjkIntersectFrom(Collider3D *a, Collider3D *b, GjkSimplex *simplex, GjkStats *stats = nullptr);
+
+struct DistanceResult {
+    float distance = 0; // 0 if the shapes overlap
+    glm::vec3 witnessA = glm::vec3(0), witnessB = glm::vec3(0); // the closest points of a and b
+    int iterations = 0;
+    int supportCalls = 0;
+};
+
+// Distances are found to within this fraction of themselves.
+const float kGjkDistanceTolerance = 1e-4f;
+
+// The distance between a and b, and their closest points. Returns false, with a distance of 0, if they overlap, for
+// which epaPenetration gives the depth instead. b can be null for the distance from the origin to a alone.
+// If warmStart is given, the query starts from its simplex, and leaves its final simplex there for the next query. The
+// points of the old simplex are looked up again in the directions that found them, so they follow moving shapes, and
+// a query between shapes that only moved a little since the last one usually converges in an iteration or two.
+// An empty simplex starts cold.
+bool gjkDistance(Collider3D *a, Collider3D *b, DistanceResult *result, GjkSimplex *warmStart = nullptr);
+
+struct RayHit {
+    float fraction = 1; // of the translation, where the ray first touches the shape, or 1 for a miss
+    glm::vec3 normal = glm::vec3(0); // the shape's unit outward normal there, or 0 for a miss or a ray starting inside
+    int iterations = 0;
+    int supportCalls = 0;
+};
+
+// Hit points are found to within this fraction of their distance to the far side of the shape.
+const float kGjkCastTolerance = 1e-5f;
+
+// Casts the ray from origin along translation against shape, by conservative advancement: each support point either
+// shows the ray can't reach the shape, or moves the ray's start as far as it can safely go. Returns false if the ray
+// misses within the translation. A ray starting inside the shape hits at fraction 0.
+bool gjkRaycast(Collider3D *shape, glm::vec3 origin, glm::vec3 translation, RayHit *hit);
+
+// Casts a, moving by translation, against b, without building anything: a ray from the origin against b - a.
+// The normal is b's outward normal where they touch.
+bool gjkShapeCast(Collider3D *a, glm::vec3 translation, Collider3D *b, RayHit *hit);
+
+// Many rays, stored as separate coordinate arrays.
+struct RayBatch3D {
+    std::vector<float> originX, originY, originZ;
+    std::vector<float> translationX, translationY, translationZ;
+
+    size_t size() const { return originX.size(); }
+    void add(glm::vec3 origin, glm::vec3 translation);
+};
+
+// The results of a batch, one per ray, in the same layout, with the fields of RayHit.
+struct RayBatchHits3D {
+    std::vector<uint8_t> hit; // 1 if the ray hit
+    std::vector<float> fraction;
+    std::vector<float> normalX, normalY, normalZ;
+    std::vector<int> iterations;
+};
+
+// Casts every ray of the batch against shape, in blocks split across sharedWorkerPool(). Each ray gets exactly the
+// result gjkRaycast gives it, whatever the number of threads. shape's findSupport must be safe to call from several
+// threads, which it is for all the colliders here.
+void gjkRaycast(Collider3D *shape, const RayBatch3D &rays, RayBatchHits3D *hits);
+
+#endif //MINKOWSKIHULL3D_GJK3D_H
@@ -2,15 +2,123 @@
 // Created by Martin Wickham on 3/2/17.
 //
 
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <vector>
+
 #include "hull3D.h"
 
 using namespace std;
 using namespace glm;
 
+// The latest direction a shared collider was asked about, with its answers for it and for its negation.
+struct DirectionMemo {
+    vec3 direction = vec3(0);
+    vec3 answers[2];
+    bool known[2] = {false, false};
+};
+
+struct SharedMemo {
+    uint64_t owner = 0; // the serial of the collider the memos are for, since slots are reused
+    DirectionMemo support;
+    DirectionMemo core;
+};
+
+// Slots of destroyed colliders are given back and reused, so the memos of every thread only grow to the most shared
+// colliders alive at once.
+static mutex slotLock;
+static size_t sharedSlots = 0;
+static vector<size_t> freeSlots;
+static atomic<uint64_t> sharedSerials(0);
+// A deque, so growing it while a query is in progress doesn't move the memos of the colliders above.
+static thread_local deque<SharedMemo> sharedMemos;
+
+static size_t takeSlot() {
+    lock_guard<mutex> guard(slotLock);
+    if (freeSlots.empty()) return sharedSlots++;
+    size_t slot = freeSlots.back();
+    freeSlots.pop_back();
+    return slot;
+}
+
+static SharedMemo &sharedMemo(size_t slot, uint64_t serial) {
+    if (sharedMemos.size() <= slot) sharedMemos.resize(slot + 1);
+    SharedMemo &memo = sharedMemos[slot];
+    if (memo.owner != serial) {
+        memo = SharedMemo();
+        memo.owner = serial;
+    }
+    return memo;
+}
+
+template <typename Evaluate>
+static vec3 memoize(DirectionMemo &memo, vec3 direction, Evaluate evaluate) {
+    int side = direction == memo.direction ? 0 : direction == -memo.direction ? 1 : -1;
+    if (side < 0) {
+        memo.direction = direction;
+        memo.known[0] = memo.known[1] = false;
+        side = 0;
+    }
+    if (!memo.known[side]) {
+        memo.answers[side] = evaluate(direction);
+        memo.known[side] = true;
+    }
+    return memo.answers[side];
+}
+
+SharedCollider3D::SharedCollider3D(Collider3D *inner) : inner(inner), slot(takeSlot()), serial(++sharedSerials) {}
+
+SharedCollider3D::~SharedCollider3D() {
+    lock_guard<mutex> guard(slotLock);
+    freeSlots.push_back(slot);
+}
+
+vec3 SharedCollider3D::findSupport(vec3 direction) {
+    return memoize(sharedMemo(slot, serial).support, direction, [this](vec3 dir) { return inner->findSupport(dir); });
+}
+
+vec3 SharedCollider3D::findCoreSupport(vec3 direction) {
+    return memoize(sharedMemo(slot, serial).core, direction,
+                   [this](vec3 dir) { return inner->findCoreSupport(dir); });
+}
+
+mat3 axisAngleRotation(vec3 axisAngle) {
+    float angle = length(axisAngle);
+    if (angle == 0) return mat3(1);
+    // Rodrigues' formula, with skew taking v to axis x v.
+    vec3 axis = axisAngle / angle;
+    mat3 skew = mat3(0, axis.z, -axis.y, -axis.z, 0, axis.x, axis.y, -axis.x, 0);
+    return mat3(1) + std::sin(angle) * skew + (1 - std::cos(angle)) * (skew * skew);
+}
+
+void PointHullCollider3D::setPoints(const vector<vec3> &points) {
+    count = points.size();
+    size_t padded = (count + kSupportScanLanes - 1) / kSupportScanLanes * kSupportScanLanes;
+    xs.resize(padded);
+    ys.resize(padded);
+    zs.resize(padded);
+    for (size_t c = 0; c < padded; c++) {
+        const vec3 &pt = points[c < count ? c : count - 1];
+        xs[c] = pt.x;
+        ys[c] = pt.y;
+        zs[c] = pt.z;
+    }
+}
+
+vector<vec3> PointHullCollider3D::points() const {
+    vector<vec3> points;
+    points.reserve(count);
+    for (size_t c = 0; c < count; c++) points.push_back(point(c));
+    return points;
+}
+
 void SurfaceState::init() {
     current = 0;
-    vec3 top = object->findSupport(vec3(0, 1, 0));
-    vec3 bottom = object->findSupport(vec3(0, -1, 0));
+    margin = splitMargin ? object->margin() : 0;
+    vec3 top = findSupport(vec3(0, 1, 0));
+    vec3 bottom = findSupport(vec3(0, -1, 0));
 
     if (top.y == bottom.y) {
         current = 65535;
@@ -21,9 +129,9 @@ void SurfaceState::init() {
     vec3 perp = vec3(top.x - bottom.x, 0, bottom.z - top.z);
     if (perp == vec3(0)) perp = vec3(0,0,1); // if top-bottom is vertical, we can pick any vector on the xz plane. Z should suffice.
 
-    vec3 left = object->findSupport(perp);
+    vec3 left = findSupport(perp);
     if (left == top || left == bottom) {
-        left = object->findSupport(-perp);
+        left = findSupport(-perp);
         if (left == top || left == bottom) {
             current = 65535;
             return;
@@ -68,25 +176,29 @@ void SurfaceState::step() {
     // ignore degenerates and move to the next triangle
     if (normal == vec3(0)) {
         printf("Degenerate Triangle at %d!\n", current);
-        current++;
+        accept();
         return;
     }
 
-    vec3 support = object->findSupport(normal);
+    vec3 support = findSupport(normal);
 
     // If the support is within epsilon of the surface, this face is complete. Move to the next triangle.
     if (dot(normalize(normal), support - a) <= epsilon) {
-        current++;
+        accept();
         return;
     }
 
 
+    split(current, support);
+}
+
+void SurfaceState::split(uint16_t triangle, vec3 support) {
     uint16_t pointIndex = points.size();
     points.push_back(support);
 
-    // Otherwise we need to replace the current triangle with three triangles
-    // NOTE: expand may not be valid beyond this point, if the vector reallocates.
-    uint16_t triAIndex = current;
+    // Replace the triangle with three triangles
+    // NOTE: references to triangles may not be valid beyond this point, if the vector reallocates.
+    uint16_t triAIndex = triangle;
     uint16_t triBIndex = triangles.size();
     triangles.emplace_back();
     uint16_t triCIndex = triangles.size();
@@ -119,6 +231,11 @@ void SurfaceState::step() {
     triA.edges[2].vertex = pointIndex;
     triA.edges[1].opposite = triBIndex * 4 + 3;
     triA.edges[2].opposite = triCIndex * 4 + 2;
+    if (changed) {
+        changed->push_back(triAIndex);
+        changed->push_back(triBIndex);
+        changed->push_back(triCIndex);
+    }
 
     // Now we need to check across the edges and make sure the shape is still convex.
     maybeSwapEdge(triAIndex * 4 + 1);
@@ -140,6 +257,12 @@ void SurfaceState::maybeSwapEdge(uint16_t base) {
     vec3 d = points[edges()[oppPrev].vertex];
 
     if (dot(cross(a - c, b - c), d - c) <= 0) return;
+    retract(base / 4);
+    retract(oppBase / 4);
+    if (changed) {
+        changed->push_back(base / 4);
+        changed->push_back(oppBase / 4);
+    }
 
     // fix up vertices
     edges()[next].vertex = edges()[oppPrev].vertex;
@@ -158,3 +281,57 @@ void SurfaceState::maybeSwapEdge(uint16_t base) {
     maybeSwapEdge(base);
     maybeSwapEdge(oppPrev);
 }
+
+void SurfaceState::accept() {
+    uint16_t accepted = current++;
+    if (!sink) return;
+
+    // Only triangles around the vertices of the accepted one can have just settled, and only if the vertex did.
+    for (int k = 0; k < 3; k++) {
+        uint16_t start = uint16_t(accepted * 4 + 1 + k);
+        if (!settledAround(start)) continue;
+        uint16_t edge = start;
+        do {
+            emitSettled(edge / 4);
+            edge = edges()[prevEdge(edge)].opposite;
+        } while (edge != start);
+    }
+
+    // Flips can also settle triangles without accepting anything, so whatever is left goes out at the end.
+    if (done()) {
+        for (uint16_t t = 0, n = uint16_t(triangles.size()); t < n; t++) emitSettled(t);
+    }
+}
+
+// Whether every triangle around the vertex the edge starts at has been accepted.
+bool SurfaceState::settledAround(uint16_t start) {
+    // The edge into the vertex is the previous one, and its opposite starts at the vertex again, in the next triangle.
+    uint16_t edge = start;
+    do {
+        if (edge / 4 >= current) return false;
+        edge = edges()[prevEdge(edge)].opposite;
+    } while (edge != start);
+    return true;
+}
+
+void SurfaceState::emitSettled(uint16_t triangle) {
+    Triangle &tri = triangles[triangle];
+    if (triangle >= current || (tri.flags & kTriangleEmitted)) return;
+    for (int k = 0; k < 3; k++) {
+        if (!settledAround(uint16_t(triangle * 4 + 1 + k))) return;
+    }
+    vec3 a = points[tri.edges[0].vertex];
+    vec3 b = points[tri.edges[1].vertex];
+    vec3 c = points[tri.edges[2].vertex];
+    if (cross(c - b, a - b) == vec3(0)) return;
+    tri.flags |= kTriangleEmitted;
+    sink->face(triangle, a, b, c);
+}
+
+void SurfaceState::retract(uint16_t triangle) {
+    Triangle &tri = triangles[triangle];
+    if (!(tri.flags & kTriangleEmitted)) return;
+    tri.flags &= ~kTriangleEmitted;
+    retractedFaces++;
+    sink->retract(triangle);
+}
@@ -7,10 +7,18 @@
 
 #include <glm/glm.hpp>
 #include <vector>
+#include <string>
 #include <cstdint>
+#include "supportScan3D.h"
 
 struct Collider3D {
     virtual glm::vec3 findSupport(glm::vec3 direction) = 0;
+
+    // Colliders can be split into a polytope core and a sphere margin, such that
+    // findSupport(d) == findCoreSupport(d) + margin() * normalize(d).
+    // Hulling the core instead of the full shape avoids tessellating the rounded parts.
+    virtual float margin() { return 0; }
+    virtual glm::vec3 findCoreSupport(glm::vec3 direction) { return findSupport(direction); }
 };
 
 struct AddCollider3D : public Collider3D {
@@ -20,6 +28,11 @@ struct AddCollider3D : public Collider3D {
     glm::vec3 findSupport(glm::vec3 direction) override {
         return a->findSupport(direction) + b->findSupport(direction);
     }
+
+    float margin() override { return a->margin() + b->margin(); }
+    glm::vec3 findCoreSupport(glm::vec3 direction) override {
+        return a->findCoreSupport(direction) + b->findCoreSupport(direction);
+    }
 };
 
 struct SubCollider3D : public Collider3D {
@@ -29,6 +42,68 @@ struct SubCollider3D : public Collider3D {
     glm::vec3 findSupport(glm::vec3 direction) override {
         return a->findSupport(direction) - b->findSupport(-direction);
     }
+
+    // the margin of b is subtracted in the opposite direction, so it grows the result too.
+    float margin() override { return a->margin() + b->margin(); }
+    glm::vec3 findCoreSupport(glm::vec3 direction) override {
+        return a->findCoreSupport(direction) - b->findCoreSupport(-direction);
+    }
+};
+
+// Stands in for a collider that is referenced from several places in a DAG of colliders, so that it is evaluated at
+// most once per direction. Nodes are usually reached again with the same direction, or with its negation through a sub,
+// so only the latest direction and its negation are remembered. The memo is per thread. The collider inside must not
+// change while this refers to it.
+struct SharedCollider3D : public Collider3D {
+    Collider3D *inner;
+    size_t slot; // this collider's entry in the per thread memos, given back on destruction
+    uint64_t serial; // unique to this collider, so a reused slot's old memos aren't mistaken for its own
+
+    explicit SharedCollider3D(Collider3D *inner);
+    ~SharedCollider3D();
+    SharedCollider3D(const SharedCollider3D &) = delete;
+    SharedCollider3D &operator=(const SharedCollider3D &) = delete;
+
+    glm::vec3 findSupport(glm::vec3 direction) override;
+    float margin() override { return inner->margin(); }
+    glm::vec3 findCoreSupport(glm::vec3 direction) override;
+};
+
+// A collider swept along a translation, which is its minkowski sum with the segment from the origin to the translation.
+// Costs one dot product more than the collider alone. Directions perpendicular to the sweep get the start.
+struct SweptCollider3D : public Collider3D {
+    Collider3D *inner;
+    glm::vec3 translation = glm::vec3(0);
+
+    glm::vec3 findSupport(glm::vec3 direction) override {
+        glm::vec3 support = inner->findSupport(direction);
+        return glm::dot(direction, translation) > 0 ? support + translation : support;
+    }
+
+    float margin() override { return inner->margin(); }
+    glm::vec3 findCoreSupport(glm::vec3 direction) override {
+        glm::vec3 support = inner->findCoreSupport(direction);
+        return glm::dot(direction, translation) > 0 ? support + translation : support;
+    }
+};
+
+// The rotation about the axis of axisAngle, by its length in radians.
+glm::mat3 axisAngleRotation(glm::vec3 axisAngle);
+
+// A collider rotated about its origin, then moved to position.
+struct TransformCollider3D : public Collider3D {
+    Collider3D *inner;
+    glm::mat3 rotation = glm::mat3(1);
+    glm::vec3 position = glm::vec3(0);
+
+    glm::vec3 findSupport(glm::vec3 direction) override {
+        return rotation * inner->findSupport(glm::transpose(rotation) * direction) + position;
+    }
+
+    float margin() override { return inner->margin(); }
+    glm::vec3 findCoreSupport(glm::vec3 direction) override {
+        return rotation * inner->findCoreSupport(glm::transpose(rotation) * direction) + position;
+    }
 };
 
 struct PointCollider3D : public Collider3D {
@@ -43,25 +118,40 @@ struct SphereCollider3D : public Collider3D {
     glm::vec3 findSupport(glm::vec3 direction) override {
         return radius * glm::normalize(direction);
     }
+
+    float margin() override { return radius; }
+    glm::vec3 findCoreSupport(glm::vec3 direction) override { return glm::vec3(0); }
 };
 
 struct PointHullCollider3D : public Collider3D {
-    std::vector<glm::vec3> points;
+    // Stored as separate coordinate arrays for the vectorized scan, padded to a multiple of kSupportScanLanes by
+    // repeating the last point. The copies never win a tie against it, so the padding doesn't change the results.
+    std::vector<float> xs, ys, zs;
+    size_t count = 0;
+    bool parallel = false; // opt in to splitting scans of kMinParallelScanPoints or more across threads
+
+    void setPoints(const std::vector<glm::vec3> &points);
+    std::vector<glm::vec3> points() const;
+    glm::vec3 point(size_t index) const { return glm::vec3(xs[index], ys[index], zs[index]); }
+
+    // The index of the first point with the greatest dot product with direction.
+    size_t findSupportIndex(glm::vec3 direction) const {
+        return pointsSupportScan(xs.data(), ys.data(), zs.data(), xs.size(), direction, parallel);
+    }
 
     glm::vec3 findSupport(glm::vec3 direction) override {
-        glm::vec3 best;
-        float bestDot = -std::numeric_limits<float>::infinity();
-        for (glm::vec3 &vec : points) {
-            float d = glm::dot(direction, vec);
-            if (d > bestDot) {
-                bestDot = d;
-                best = vec;
-            }
-        }
-        return best;
+        if (count == 0) return glm::vec3(0);
+        return point(findSupportIndex(direction));
     }
 };
 
+// A finished polytope, with faces as lists of vertices.
+struct PolytopeHull3D {
+    std::vector<glm::vec3> points;
+    std::vector<std::vector<uint32_t>> faces; // indices into points, counterclockwise seen from outside
+    std::vector<glm::vec3> normals; // unit outward normal of each face
+};
+
 struct HalfEdge {
     uint16_t vertex;
     uint16_t opposite;
@@ -72,21 +162,52 @@ struct Triangle {
     HalfEdge edges[3];
 };
 
+const uint32_t kTriangleEmitted = 1; // in Triangle::flags, once the triangle has been passed to SurfaceState::sink
+
 inline uint16_t prevEdge(uint16_t edge) {
     edge--;
     return uint16_t((edge & 3) == 0 ? edge + 3 : edge);
 }
 
+// Receives the faces of a SurfaceState as soon as they settle, and takes back the rare ones a later flip changes.
+// See SurfaceState::sink.
+struct FaceSink {
+    virtual void face(uint16_t triangle, glm::vec3 a, glm::vec3 b, glm::vec3 c) = 0;
+    // The face last emitted for triangle is no longer part of the hull. The triangle is emitted again once it settles.
+    virtual void retract(uint16_t triangle) = 0;
+};
+
 struct SurfaceState {
     Collider3D *object;
     float epsilon;
+    bool splitMargin = false; // if set, only the core of the object is hulled. See Collider3D::margin.
+    // If set, polytopes get their exact hull from buildExactHull instead of being probed, which is several times
+    // slower. See gaussMap3D.h.
+    bool exact = false;
+    float margin = 0; // the radius to add to the hull to get the full object. Set by init().
+    std::string cacheDirectory; // if set, finished hulls are kept here and reused across runs. See hullCache3D.h.
+    size_t cacheBytes = 64 << 20; // the least recently used hulls are evicted beyond this
+    // If set, step() passes faces to the sink as soon as they settle, so consumers can start before the hull is done.
+    // A face settles once it and every triangle around its vertices are accepted. That almost always makes it final,
+    // but a later support up to epsilon in front of it can start flips that reach it. Flips are never refused, so the
+    // hull is the same with or without a sink. Instead the sink is told to retract each changed face, which it gets
+    // again once it settles, and retractedFaces counts them. The faces emitted and not retracted make up the hull.
+    // Degenerate triangles aren't emitted, and neither are hulls that were built or loaded without stepping.
+    FaceSink *sink = nullptr;
+    size_t retractedFaces = 0;
+    // If set, split() appends every triangle it creates or changes, including by flips, so callers that pick which
+    // triangle to expand next themselves can re-examine them.
+    std::vector<uint16_t> *changed = nullptr;
     std::vector<glm::vec3> points;
     std::vector<Triangle> triangles;
     uint16_t current;
 
     void init();
     void step();
-    inline bool done() {
+    // Replaces triangle with three triangles fanned around support, which is added to points, then flips edges until
+    // the surface is convex again.
+    void split(uint16_t triangle, glm::vec3 support);
+    inline bool done() const {
         return current >= triangles.size();
     }
     inline HalfEdge *edges() {
@@ -94,6 +215,13 @@ struct SurfaceState {
         return reinterpret_cast<HalfEdge *>(&triangles[0]);
     }
     void maybeSwapEdge(uint16_t edge);
+    void accept();
+    bool settledAround(uint16_t edge);
+    void emitSettled(uint16_t triangle);
+    void retract(uint16_t triangle);
+    inline glm::vec3 findSupport(glm::vec3 direction) {
+        return splitMargin ? object->findCoreSupport(direction) : object->findSupport(direction);
+    }
 };
 
 #endif //MINKOWSKIHULL3D_HULL3D_H
@@ -0,0 +1,304 @@
+//
+// A cache of finished hulls on disk, so identical configs don't have to be hulled again on every run.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "hullCache3D.h"
+#include "hullFile3D.h"
+#include "clusteredPoints3D.h"
+#include "bakedHull3D.h"
+#include "pointsFile3D.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#include <sys/utime.h>
+#define getpid _getpid
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+using namespace std;
+using namespace glm;
+
+static const char *kHullCacheExtension = ".hull";
+
+// FNV-1a, 64 bit. If record is set, everything hashed is appended to it too.
+struct Hasher {
+    uint64_t hash = 14695981039346656037ull;
+    string *record = nullptr;
+
+    void bytes(const void *data, size_t size) {
+        const unsigned char *c = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash ^= c[i];
+            hash *= 1099511628211ull;
+        }
+        if (record) record->append(static_cast<const char *>(data), size);
+    }
+    void word(uint64_t value) { bytes(&value, sizeof(value)); }
+    void real(float value) {
+        if (value == 0) value = 0; // -0 and 0 act the same
+        bytes(&value, sizeof(value));
+    }
+    void point(vec3 pt) {
+        real(pt.x);
+        real(pt.y);
+        real(pt.z);
+    }
+};
+
+// Hashes point sets by FNV, and by a multiplicative mix of the same bits that collides independently of it. Only the
+// hashes, the count and the ends go into the node, so descriptions stay small.
+struct PointsDigest {
+    Hasher fnv;
+    uint64_t mix = 0;
+    size_t count = 0;
+    vec3 first = vec3(0), last = vec3(0);
+
+    void point(vec3 pt) {
+        fnv.point(pt);
+        for (int c = 0; c < 3; c++) {
+            uint32_t bits;
+            float value = pt[c] == 0 ? 0 : pt[c];
+            memcpy(&bits, &value, sizeof(bits));
+            mix = (mix ^ bits) * 0x9e3779b97f4a7c15ull;
+            mix ^= mix >> 29;
+        }
+        if (count++ == 0) first = pt;
+        last = pt;
+    }
+
+    void hashInto(Hasher &h) const {
+        h.word(count);
+        h.point(first);
+        h.point(last);
+        h.word(fnv.hash);
+        h.word(mix);
+    }
+};
+
+// Each node's bytes are appended to description after its children's, so equal graphs describe the same.
+static uint64_t hashNode(Collider3D *collider, unordered_map<Collider3D *, uint64_t> &hashes, string *description) {
+    auto found = hashes.find(collider);
+    if (found != hashes.end()) return found->second;
+
+    Hasher h;
+    PointsDigest digest;
+    if (SharedCollider3D *shared = dynamic_cast<SharedCollider3D *>(collider)) {
+        return hashes[collider] = hashNode(shared->inner, hashes, description);
+    } else if (PointCollider3D *point = dynamic_cast<PointCollider3D *>(collider)) {
+        h.record = description;
+        h.word('P');
+        h.point(point->point);
+    } else if (SphereCollider3D *sphere = dynamic_cast<SphereCollider3D *>(collider)) {
+        h.record = description;
+        h.word('S');
+        h.real(sphere->radius);
+    } else if (PointHullCollider3D *points = dynamic_cast<PointHullCollider3D *>(collider)) {
+        // Every way of storing points hashes the same, since they all have the same support function.
+        for (size_t c = 0; c < points->count; c++) digest.point(points->point(c));
+        h.record = description;
+        h.word('H');
+        digest.hashInto(h);
+    } else if (ClusteredPointsCollider3D *clustered = dynamic_cast<ClusteredPointsCollider3D *>(collider)) {
+        for (const vec3 &pt : clustered->points()) digest.point(pt);
+        h.record = description;
+        h.word('H');
+        digest.hashInto(h);
+    } else if (PointViewCollider3D *view = dynamic_cast<PointViewCollider3D *>(collider)) {
+        for (size_t c = 0; c < view->count; c++) digest.point(view->point(c));
+        h.record = description;
+        h.word('H');
+        digest.hashInto(h);
+    } else if (BakedHullCollider3D *baked = dynamic_cast<BakedHullCollider3D *>(collider)) {
+        for (const vec3 &pt : baked->vertices) digest.point(pt);
+        h.record = description;
+        h.word('K');
+        h.real(baked->sphereMargin);
+        digest.hashInto(h);
+    } else if (AddCollider3D *add = dynamic_cast<AddCollider3D *>(collider)) {
+        uint64_t a = hashNode(add->a, hashes, description), b = hashNode(add->b, hashes, description);
+        if (a == 0 || b == 0) return hashes[collider] = 0;
+        h.record = description;
+        h.word('A');
+        h.word(a);
+        h.word(b);
+    } else if (SubCollider3D *sub = dynamic_cast<SubCollider3D *>(collider)) {
+        uint64_t a = hashNode(sub->a, hashes, description), b = hashNode(sub->b, hashes, description);
+        if (a == 0 || b == 0) return hashes[collider] = 0;
+        h.record = description;
+        h.word('B');
+        h.word(a);
+        h.word(b);
+    } else if (SweptCollider3D *swept = dynamic_cast<SweptCollider3D *>(collider)) {
+        uint64_t inner = hashNode(swept->inner, hashes, description);
+        if (inner == 0) return hashes[collider] = 0;
+        h.record = description;
+        h.word('W');
+        h.word(inner);
+        h.point(swept->translation);
+    } else {
+        return hashes[collider] = 0;
+    }
+    if (h.hash == 0) h.hash = 1; // 0 means uncacheable
+    return hashes[collider] = h.hash;
+}
+
+uint64_t hashCollider(Collider3D *collider) {
+    unordered_map<Collider3D *, uint64_t> hashes;
+    return hashNode(collider, hashes, nullptr);
+}
+
+HullCacheKey hullCacheKey(const SurfaceState &state) {
+    HullCacheKey key;
+    unordered_map<Collider3D *, uint64_t> hashes;
+    uint64_t object = hashNode(state.object, hashes, &key.description);
+    if (object == 0) {
+        key.description.clear();
+        return key;
+    }
+    Hasher h;
+    h.record = &key.description;
+    h.word(kHullCacheVersion);
+    h.word(object);
+    h.real(state.epsilon);
+    h.word(state.splitMargin);
+    h.word(state.exact);
+    key.hash = h.hash == 0 ? 1 : h.hash;
+    return key;
+}
+
+static string cachePath(const string &directory, uint64_t key) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long) key);
+    return directory + "/" + name + kHullCacheExtension;
+}
+
+bool loadCachedHull(SurfaceState *state, const HullCacheKey &key) {
+    if (state->cacheDirectory.empty() || key.hash == 0) return false;
+    string path = cachePath(state->cacheDirectory, key.hash);
+    HullFile file;
+    if (!file.open(path.c_str())) return false;
+    const HullFileHeader &header = *file.header;
+    // The hash only picks the file, so a colliding key can't return another object's hull.
+    if (header.key != key.hash || !file.sourceMatches(key.description)) return false;
+    if (header.current != header.triangleCount || header.triangleCount * 4 > 65536) return false;
+
+    // Check the topology before trusting it, so a damaged file can't send the mesh code out of bounds.
+    for (const Triangle *tri = file.triangles(), *end = tri + header.triangleCount; tri != end; tri++) {
+        for (const HalfEdge &edge : tri->edges) {
+            bool outOfBounds = edge.vertex >= header.pointCount || edge.opposite >= header.triangleCount * 4;
+            if (outOfBounds || edge.opposite % 4 == 0) return false;
+        }
+    }
+    file.copyTo(state);
+
+    // Reading bumps the modification time, which is what eviction goes by.
+#ifdef _WIN32
+    _utime(path.c_str(), nullptr);
+#else
+    utime(path.c_str(), nullptr);
+#endif
+    return true;
+}
+
+struct CacheEntry {
+    string path;
+    size_t size;
+    long long modified;
+};
+
+static vector<CacheEntry> listCache(const string &directory) {
+    vector<CacheEntry> entries;
+    size_t extension = strlen(kHullCacheExtension);
+#ifdef _WIN32
+    WIN32_FIND_DATAA found;
+    HANDLE search = FindFirstFileA((directory + "/*" + kHullCacheExtension).c_str(), &found);
+    if (search == INVALID_HANDLE_VALUE) return entries;
+    do {
+        CacheEntry entry;
+        entry.path = directory + "/" + found.cFileName;
+        entry.size = (size_t(found.nFileSizeHigh) << 32) | found.nFileSizeLow;
+        entry.modified = ((long long) found.ftLastWriteTime.dwHighDateTime << 32) | found.ftLastWriteTime.dwLowDateTime;
+        entries.push_back(entry);
+    } while (FindNextFileA(search, &found));
+    FindClose(search);
+#else
+    DIR *dir = opendir(directory.c_str());
+    if (!dir) return entries;
+    while (dirent *item = readdir(dir)) {
+        string name = item->d_name;
+        if (name.size() <= extension || name.compare(name.size() - extension, extension, kHullCacheExtension) != 0) {
+            continue;
+        }
+        CacheEntry entry;
+        entry.path = directory + "/" + name;
+        struct stat info;
+        if (stat(entry.path.c_str(), &info) != 0) continue;
+        entry.size = size_t(info.st_size);
+        entry.modified = (long long) info.st_mtime;
+        entries.push_back(entry);
+    }
+    closedir(dir);
+#endif
+    return entries;
+}
+
+// Never removes keep, which was just written, since modification times are too coarse to tell it from older files.
+static void evict(const string &directory, size_t maxBytes, const string &keep) {
+    vector<CacheEntry> entries = listCache(directory);
+    size_t total = 0;
+    for (const CacheEntry &entry : entries) total += entry.size;
+    if (total <= maxBytes) return;
+
+    sort(entries.begin(), entries.end(), [](const CacheEntry &a, const CacheEntry &b) {
+        return a.modified < b.modified;
+    });
+    for (const CacheEntry &entry : entries) {
+        if (total <= maxBytes) break;
+        if (entry.path == keep) continue;
+        if (remove(entry.path.c_str()) == 0) total -= entry.size;
+    }
+}
+
+bool storeCachedHull(const SurfaceState &state, const HullCacheKey &key) {
+    if (state.cacheDirectory.empty() || key.hash == 0 || !state.done()) return false;
+
+#ifdef _WIN32
+    _mkdir(state.cacheDirectory.c_str());
+#else
+    mkdir(state.cacheDirectory.c_str(), 0755);
+#endif
+
+    // Written to a temporary file and renamed into place, so readers never see half a hull. The temporary name is
+    // unique to this process and call, so writers storing the same key at once don't write into each other's file.
+    static atomic<unsigned> temporaries(0);
+    string path = cachePath(state.cacheDirectory, key.hash);
+    char suffix[48];
+    snprintf(suffix, sizeof(suffix), ".%d-%u.tmp", int(getpid()), temporaries++);
+    string temporary = path + suffix;
+#ifdef _WIN32
+    remove(path.c_str()); // rename doesn't replace files on Windows
+#endif
+    bool written = writeHullFile(temporary.c_str(), state, HULL_FILE_SOURCE, key.hash, key.description);
+    if (!written || rename(temporary.c_str(), path.c_str()) != 0) {
+        printf("Failed to write hull cache file '%s'.\n", path.c_str());
+        remove(temporary.c_str());
+        return false;
+    }
+
+    evict(state.cacheDirectory, state.cacheBytes, path);
+    return true;
+}
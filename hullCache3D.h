@@ -0,0 +1,41 @@
+//
+// A cache of finished hulls on disk, so identical configs don't have to be hulled again on every run.
+//
+
+#ifndef MINKOWSKIHULL3D_HULLCACHE3D_H
+#define MINKOWSKIHULL3D_HULLCACHE3D_H
+
+#include <string>
+
+#include "hull3D.h"
+
+// Part of every key, so bump it whenever the hash changes. Hulls cached under other versions are never hit, and age
+// out. Cached hulls are stored as hull files, see hullFile3D.h.
+const uint32_t kHullCacheVersion = 4;
+
+// A structural hash of a collider graph: its types, parameters and point sets, with shared nodes hashed once.
+// Colliders with the same hash have the same support function. Returns 0 if the graph contains a type it doesn't know,
+// which can't be cached then.
+uint64_t hashCollider(Collider3D *collider);
+
+// Identifies state's hull: the hash of its object, its epsilon, and whether it splits the margin or is exact, which
+// names the file, and a description of the same, which is stored in the file and compared on load, so a hash collision
+// can't load the wrong hull. The description lists every node of the graph, with its type, parameters and children.
+// Point sets are described by their count, their ends, and a second hash of their points unrelated to the first, so the
+// description stays small for big clouds.
+struct HullCacheKey {
+    uint64_t hash = 0; // 0 if uncacheable
+    std::string description;
+};
+
+HullCacheKey hullCacheKey(const SurfaceState &state);
+
+// Fills state with the finished hull stored under key in state->cacheDirectory, and marks the file as recently used.
+// Returns false, leaving state untouched, if there is none, it's unreadable, or it was stored for another description.
+bool loadCachedHull(SurfaceState *state, const HullCacheKey &key);
+
+// Stores state's finished hull under key, then evicts the least recently used hulls, other than this one, until the
+// cache fits in state.cacheBytes. Does nothing if state has no cache directory, isn't done, or key is uncacheable.
+bool storeCachedHull(const SurfaceState &state, const HullCacheKey &key);
+
+#endif //MINKOWSKIHULL3D_HULLCACHE3D_H
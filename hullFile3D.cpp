@@ -0,0 +1,169 @@
+//
+// A binary hull format that can be memory mapped and used in place.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "hullFile3D.h"
+
+using namespace std;
+using namespace glm;
+
+static_assert(sizeof(HullFileHeader) == 104, "The hull file header must have no padding.");
+static_assert(sizeof(Triangle) == 16 && sizeof(vec3) == 12 && sizeof(vec4) == 16,
+              "Hull file sections are stored as they are in memory.");
+
+static const char kHullFileMagic[4] = {'M', 'K', 'H', 'F'};
+static const uint64_t kSectionAlignment = 16;
+
+static uint64_t align(uint64_t offset) {
+    return (offset + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment;
+}
+
+// Writes a section at its offset, padding up to it with zeros.
+static bool writeSection(FILE *file, uint64_t &written, uint64_t offset, const void *data, size_t size) {
+    static const char zeros[kSectionAlignment] = {};
+    if (offset == 0) return true;
+    if (fwrite(zeros, 1, size_t(offset - written), file) != offset - written) return false;
+    written = offset + size;
+    return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+bool writeHullFile(const char *path, const SurfaceState &state, uint32_t sections, uint64_t key,
+                   const string &source) {
+    if (!hostIsLittleEndian()) {
+        printf("Hull files are little endian, and can't be written on this machine.\n");
+        return false;
+    }
+    HullFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kHullFileMagic, 4);
+    header.version = kHullFileVersion;
+    header.byteOrder = kHullFileByteOrder;
+    header.sections = sections;
+    header.pointCount = uint32_t(state.points.size());
+    header.triangleCount = uint32_t(state.triangles.size());
+    header.current = state.current;
+    header.epsilon = state.epsilon;
+    header.margin = state.margin;
+    header.key = key;
+
+    vector<vec4> planes;
+    if (sections & HULL_FILE_PLANES) {
+        for (const Triangle &tri : state.triangles) {
+            vec3 a = state.points[tri.edges[0].vertex];
+            vec3 b = state.points[tri.edges[1].vertex];
+            vec3 c = state.points[tri.edges[2].vertex];
+            vec3 normal = cross(c - b, a - b);
+            if (normal != vec3(0)) normal = normalize(normal);
+            planes.push_back(vec4(normal, dot(normal, a)));
+        }
+    }
+
+    vector<uint32_t> neighborStart, neighbors;
+    if (sections & HULL_FILE_ADJACENCY) {
+        vector<vector<uint32_t>> adjacent(state.points.size());
+        for (const Triangle &tri : state.triangles) {
+            for (int c = 0; c < 3; c++) {
+                adjacent[tri.edges[c].vertex].push_back(tri.edges[(c + 1) % 3].vertex);
+            }
+        }
+        neighborStart.push_back(0);
+        for (vector<uint32_t> &list : adjacent) {
+            sort(list.begin(), list.end());
+            list.erase(unique(list.begin(), list.end()), list.end());
+            neighbors.insert(neighbors.end(), list.begin(), list.end());
+            neighborStart.push_back(uint32_t(neighbors.size()));
+        }
+        header.neighborCount = uint32_t(neighbors.size());
+    }
+
+    uint64_t end = sizeof(header);
+    header.points = align(end);
+    end = header.points + state.points.size() * sizeof(vec3);
+    header.triangles = align(end);
+    end = header.triangles + state.triangles.size() * sizeof(Triangle);
+    if (sections & HULL_FILE_PLANES) {
+        header.planes = align(end);
+        end = header.planes + planes.size() * sizeof(vec4);
+    }
+    if (sections & HULL_FILE_ADJACENCY) {
+        header.neighborStart = align(end);
+        end = header.neighborStart + neighborStart.size() * sizeof(uint32_t);
+        header.neighbors = align(end);
+        end = header.neighbors + neighbors.size() * sizeof(uint32_t);
+    }
+    if (sections & HULL_FILE_SOURCE) {
+        header.source = align(end);
+        header.sourceBytes = source.size();
+        end = header.source + source.size();
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        printf("Failed to open '%s' for writing.\n", path);
+        return false;
+    }
+    uint64_t written = sizeof(header);
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && writeSection(file, written, header.points, state.points.data(), state.points.size() * sizeof(vec3));
+    ok = ok && writeSection(file, written, header.triangles, state.triangles.data(),
+                            state.triangles.size() * sizeof(Triangle));
+    ok = ok && writeSection(file, written, header.planes, planes.data(), planes.size() * sizeof(vec4));
+    ok = ok && writeSection(file, written, header.neighborStart, neighborStart.data(),
+                            neighborStart.size() * sizeof(uint32_t));
+    ok = ok && writeSection(file, written, header.neighbors, neighbors.data(), neighbors.size() * sizeof(uint32_t));
+    ok = ok && writeSection(file, written, header.source, source.data(), source.size());
+    ok = fclose(file) == 0 && ok;
+    if (!ok) printf("Failed to write '%s'.\n", path);
+    return ok;
+}
+
+static bool sectionFits(uint64_t offset, uint64_t size, size_t fileSize) {
+    return offset == 0 || (offset % kSectionAlignment == 0 && offset <= fileSize && size <= fileSize - offset);
+}
+
+bool HullFile::open(const char *path) {
+    close();
+    if (!hostIsLittleEndian() || !file.open(path)) return false;
+    if (file.size() < sizeof(HullFileHeader)) {
+        file.close();
+        return false;
+    }
+
+    const HullFileHeader *h = reinterpret_cast<const HullFileHeader *>(file.data());
+    bool planes = (h->sections & HULL_FILE_PLANES) != 0;
+    bool adjacency = (h->sections & HULL_FILE_ADJACENCY) != 0;
+    bool source = (h->sections & HULL_FILE_SOURCE) != 0;
+    bool valid = memcmp(h->magic, kHullFileMagic, 4) == 0 && h->byteOrder == kHullFileByteOrder &&
+                 h->version == kHullFileVersion &&
+                 h->points != 0 && h->triangles != 0 && (h->planes != 0) == planes &&
+                 (h->neighborStart != 0) == adjacency && (h->neighbors != 0) == adjacency &&
+                 (h->source != 0) == source &&
+                 sectionFits(h->points, uint64_t(h->pointCount) * sizeof(vec3), file.size()) &&
+                 sectionFits(h->triangles, uint64_t(h->triangleCount) * sizeof(Triangle), file.size()) &&
+                 sectionFits(h->planes, uint64_t(h->triangleCount) * sizeof(vec4), file.size()) &&
+                 sectionFits(h->neighborStart, (uint64_t(h->pointCount) + 1) * sizeof(uint32_t), file.size()) &&
+                 sectionFits(h->neighbors, uint64_t(h->neighborCount) * sizeof(uint32_t), file.size()) &&
+                 sectionFits(h->source, h->sourceBytes, file.size());
+    if (!valid) {
+        file.close();
+        return false;
+    }
+    header = h;
+    return true;
+}
+
+bool HullFile::sourceMatches(const string &bytes) const {
+    return source() && header->sourceBytes == bytes.size() && memcmp(source(), bytes.data(), bytes.size()) == 0;
+}
+
+void HullFile::copyTo(SurfaceState *state) const {
+    state->points.assign(points(), points() + header->pointCount);
+    state->triangles.assign(triangles(), triangles() + header->triangleCount);
+    state->current = uint16_t(std::min<uint32_t>(header->current, 65535));
+    state->epsilon = header->epsilon;
+    state->margin = header->margin;
+}
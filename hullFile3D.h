@@ -0,0 +1,83 @@
+//
+// A binary hull format that can be memory mapped and used in place.
+//
+
+#ifndef MINKOWSKIHULL3D_HULLFILE3D_H
+#define MINKOWSKIHULL3D_HULLFILE3D_H
+
+#include <string>
+
+#include "hull3D.h"
+#include "mappedFile.h"
+
+// Bump whenever the layout changes. Readers reject other versions.
+const uint32_t kHullFileVersion = 3;
+
+enum HullFileSections {
+    HULL_FILE_PLANES = 1, // a unit outward normal and offset for every triangle
+    HULL_FILE_ADJACENCY = 2, // the neighbors of every vertex
+    HULL_FILE_SOURCE = 4, // bytes describing what the hull was built from, like the hull cache's key description
+};
+
+// Stored little endian in every header, as the bytes 04 03 02 01, so files written in another byte order are caught.
+const uint32_t kHullFileByteOrder = 0x01020304;
+
+// The file starts with this header. Every section starts at a multiple of 16 bytes, and all values are little endian,
+// laid out exactly like the structs in memory on little endian machines, so a mapped file can be used directly. Big
+// endian machines can't use them in place, so they neither write nor open hull files.
+struct HullFileHeader {
+    char magic[4]; // "MKHF"
+    uint32_t version;
+    uint32_t sections; // HullFileSections
+    uint32_t pointCount;
+    uint32_t triangleCount;
+    uint32_t neighborCount;
+    uint32_t current; // the state's current triangle, which is triangleCount once the hull is finished
+    float epsilon;
+    float margin;
+    uint32_t byteOrder; // kHullFileByteOrder
+    uint64_t key; // free for the writer's use, like the hull cache's key
+    uint64_t points; // glm::vec3[pointCount]
+    uint64_t triangles; // Triangle[triangleCount], with SurfaceState's half edge indexing
+    uint64_t planes; // glm::vec4[triangleCount] of normal and offset, or 0
+    uint64_t neighborStart; // uint32_t[pointCount + 1] of offsets into neighbors, or 0
+    uint64_t neighbors; // uint32_t[neighborCount], increasing for each vertex, or 0
+    uint64_t source; // char[sourceBytes], or 0
+    uint64_t sourceBytes;
+};
+
+// Writes state to path, with the optional sections asked for. The source section holds source. Returns false if the
+// file can't be written, or if this machine is big endian.
+bool writeHullFile(const char *path, const SurfaceState &state, uint32_t sections, uint64_t key = 0,
+                   const std::string &source = std::string());
+
+// A mapped hull file. Opening only reads the header and checks that the sections fit in the file, so the rest is paged
+// in as it is touched. The contents aren't checked, so files should come from writeHullFile.
+class HullFile {
+public:
+    bool open(const char *path);
+    void close() { file.close(); header = nullptr; }
+
+    const HullFileHeader *header = nullptr;
+    const glm::vec3 *points() const { return section<glm::vec3>(header->points); }
+    const Triangle *triangles() const { return section<Triangle>(header->triangles); }
+    const glm::vec4 *planes() const { return section<glm::vec4>(header->planes); }
+    const uint32_t *neighborStart() const { return section<uint32_t>(header->neighborStart); }
+    const uint32_t *neighbors() const { return section<uint32_t>(header->neighbors); }
+    const char *source() const { return section<char>(header->source); }
+    // Whether the file has a source section holding exactly these bytes.
+    bool sourceMatches(const std::string &bytes) const;
+
+    // Copies the hull into state, which can then continue stepping if it wasn't finished.
+    void copyTo(SurfaceState *state) const;
+
+private:
+    template <typename T>
+    const T *section(uint64_t offset) const {
+        return offset ? reinterpret_cast<const T *>(file.data() + offset) : nullptr;
+    }
+
+    MappedFile file;
+};
+
+#endif //MINKOWSKIHULL3D_HULLFILE3D_H
@@ -4,11 +4,21 @@
 
 #include <vector>
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
 
 #include "loader.h"
+#include "configTokens.h"
+#include "mappedFile.h"
 #include "hull3D.h"
+#include "quickHull3D.h"
+#include "clusteredPoints3D.h"
+#include "supportMap3D.h"
+#include "bakedHull3D.h"
+#include "pointsFile3D.h"
+#include "colliderArena.h"
+#include "scene3D.h"
 
 using namespace std;
 using namespace glm;
@@ -16,54 +26,71 @@ using namespace glm;
 struct Symbol {
     string name;
     Collider3D *value = nullptr;
+    int lineNum = 0;
 };
 
-struct Loader {
-    virtual bool load(istringstream &line, Symbol &symbol, const vector<Symbol> &symbols, int lineNum) = 0;
-};
+// Generated configs define hundreds of thousands of symbols, so they are looked up by name in a hash map.
+struct SymbolTable {
+    vector<Symbol> symbols; // in the order they were defined
+    unordered_map<string, size_t> index;
 
-const Symbol *findSymbol(const vector<Symbol> &symbols, const string &name) {
-    for (const Symbol &sym : symbols) {
-        if (sym.name == name) return &sym;
+    const Symbol *find(const string &name) const {
+        auto found = index.find(name);
+        return found == index.end() ? nullptr : &symbols[found->second];
     }
-    return nullptr;
-}
+
+    void add(const Symbol &symbol) {
+        index[symbol.name] = symbols.size();
+        symbols.push_back(symbol);
+    }
+};
+
+struct Loader {
+    // Colliders are made in the arena, which owns them from then on.
+    virtual bool load(ConfigTokens &line, Symbol &symbol, const SymbolTable &symbols, ColliderArena &arena,
+                      int lineNum) = 0;
+};
 
 struct SphereLoader : public Loader {
-    bool load(istringstream &line, Symbol &symbol, const vector<Symbol> &symbols, int lineNum) override {
-        SphereCollider3D *collider = new SphereCollider3D();
-        if (!(line >> collider->radius)) {
+    bool load(ConfigTokens &line, Symbol &symbol, const SymbolTable &symbols, ColliderArena &arena,
+              int lineNum) override {
+        float radius;
+        if (!line.number(radius)) {
             printf("Error: Failed to load sphere, line %d.\n", lineNum);
-            delete collider;
             return false;
         }
+        SphereCollider3D *collider = arena.make<SphereCollider3D>();
+        collider->radius = radius;
         symbol.value = collider;
         return true;
     }
 };
 
 struct PointLoader : public Loader {
-    bool load(istringstream &line, Symbol &symbol, const vector<Symbol> &symbols, int lineNum) override {
-        PointCollider3D *collider = new PointCollider3D();
-        if (!(line >> collider->point.x >> collider->point.y >> collider->point.z)) {
+    bool load(ConfigTokens &line, Symbol &symbol, const SymbolTable &symbols, ColliderArena &arena,
+              int lineNum) override {
+        vec3 point;
+        if (!(line.number(point.x) && line.number(point.y) && line.number(point.z))) {
             printf("Error: Failed to load point, line %d.\n", lineNum);
-            delete collider;
             return false;
         }
+        PointCollider3D *collider = arena.make<PointCollider3D>();
+        collider->point = point;
         symbol.value = collider;
         return true;
     }
 };
 
 struct AddLoader : public Loader {
-    bool load(istringstream &line, Symbol &symbol, const vector<Symbol> &symbols, int lineNum) override {
+    bool load(ConfigTokens &line, Symbol &symbol, const SymbolTable &symbols, ColliderArena &arena,
+              int lineNum) override {
         std::string a, b;
-        if (!(line >> a >> b)) {
+        if (!(line.word(a) && line.word(b))) {
             printf("Error: Not enough tokens for add, line %d.\n", lineNum);
             return false;
         }
-        const Symbol *symA = findSymbol(symbols, a);
-        const Symbol *symB = findSymbol(symbols, b);
+        const Symbol *symA = symbols.find(a);
+        const Symbol *symB = symbols.find(b);
         if (!symA) {
             printf("Error: Unknown symbol %s, line %d.\n", a.c_str(), lineNum);
             return false;
@@ -72,7 +99,7 @@ struct AddLoader : public Loader {
             printf("Error: Unknown symbol %s, line %d.\n", b.c_str(), lineNum);
             return false;
         }
-        AddCollider3D *add = new AddCollider3D();
+        AddCollider3D *add = arena.make<AddCollider3D>();
         add->a = symA->value;
         add->b = symB->value;
         symbol.value = add;
@@ -81,14 +108,15 @@ struct AddLoader : public Loader {
 };
 
 struct SubLoader : public Loader {
-    bool load(istringstream &line, Symbol &symbol, const vector<Symbol> &symbols, int lineNum) override {
+    bool load(ConfigTokens &line, Symbol &symbol, const SymbolTable &symbols, ColliderArena &arena,
+              int lineNum) override {
         std::string a, b;
-        if (!(line >> a >> b)) {
+        if (!(line.word(a) && line.word(b))) {
             printf("Error: Not enough tokens for sub, line %d.\n", lineNum);
             return false;
         }
-        const Symbol *symA = findSymbol(symbols, a);
-        const Symbol *symB = findSymbol(symbols, b);
+        const Symbol *symA = symbols.find(a);
+        const Symbol *symB = symbols.find(b);
         if (!symA) {
             printf("Error: Unknown symbol %s, line %d.\n", a.c_str(), lineNum);
             return false;
@@ -97,7 +125,7 @@ struct SubLoader : public Loader {
             printf("Error: Unknown symbol %s, line %d.\n", b.c_str(), lineNum);
             return false;
         }
-        SubCollider3D *sub = new SubCollider3D();
+        SubCollider3D *sub = arena.make<SubCollider3D>();
         sub->a = symA->value;
         sub->b = symB->value;
         symbol.value = sub;
@@ -105,17 +133,180 @@ struct SubLoader : public Loader {
     }
 };
 
+struct SweepLoader : public Loader {
+    bool load(ConfigTokens &line, Symbol &symbol, const SymbolTable &symbols, ColliderArena &arena,
+              int lineNum) override {
+        std::string name;
+        vec3 translation;
+        if (!(line.word(name) && line.number(translation.x) && line.number(translation.y) &&
+              line.number(translation.z))) {
+            printf("Error: Failed to load sweep, line %d.\n", lineNum);
+            return false;
+        }
+        const Symbol *inner = symbols.find(name);
+        if (!inner) {
+            printf("Error: Unknown symbol %s, line %d.\n", name.c_str(), lineNum);
+            return false;
+        }
+        SweptCollider3D *swept = arena.make<SweptCollider3D>();
+        swept->inner = inner->value;
+        swept->translation = translation;
+        symbol.value = swept;
+        return true;
+    }
+};
+
+static const size_t kMinPointsToReduce = 64; // not worth hulling, small sets are scanned quickly anyway
+
+// Parses the points of a points or clustered line, and drops the interior ones.
+static bool loadPoints(ConfigTokens &line, vector<vec3> &points, int lineNum) {
+    // Configs with millions of points spend most of their load time here, so the vector is sized by a first pass.
+    points.reserve(line.countTokens() / 3);
+    vec3 pt;
+    while (line.number(pt.x) && line.number(pt.y) && line.number(pt.z)) {
+        points.push_back(pt);
+    }
+    if (points.size() == 0) {
+        printf("Error: Empty point collider, line %d.\n", lineNum);
+        return false;
+    }
+
+    // Interior points can never be the support, so drop them once here instead of scanning them on every query.
+    if (points.size() > kMinPointsToReduce) {
+        chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+        PolytopeHull3D hull;
+        if (parallelQuickHull(points, &hull)) {
+            double millis = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+            printf("Reduced points on line %d from %d to %d in %.2fms.\n",
+                   lineNum, int(points.size()), int(hull.points.size()), millis);
+            points.swap(hull.points);
+        }
+    }
+    return true;
+}
+
 struct PointsLoader : public Loader {
-    bool load(istringstream &line, Symbol &symbol, const vector<Symbol> &symbols, int lineNum) override {
-        vec3 pt;
-        PointHullCollider3D *collider = new PointHullCollider3D();
-        while (line >> pt.x >> pt.y >> pt.z) {
-            collider->points.push_back(pt);
+    bool load(ConfigTokens &line, Symbol &symbol, const SymbolTable &symbols, ColliderArena &arena,
+              int lineNum) override {
+        vector<vec3> points;
+        if (!loadPoints(line, points, lineNum)) return false;
+
+        PointHullCollider3D *collider = arena.make<PointHullCollider3D>();
+        collider->setPoints(points);
+        symbol.value = collider;
+        return true;
+    }
+};
+
+struct ClusteredLoader : public Loader {
+    bool load(ConfigTokens &line, Symbol &symbol, const SymbolTable &symbols, ColliderArena &arena,
+              int lineNum) override {
+        vector<vec3> points;
+        if (!loadPoints(line, points, lineNum)) return false;
+
+        ClusteredPointsCollider3D *collider = arena.make<ClusteredPointsCollider3D>();
+        collider->setPoints(points);
+        symbol.value = collider;
+        return true;
+    }
+};
+
+struct MappedLoader : public Loader {
+    bool load(ConfigTokens &line, Symbol &symbol, const SymbolTable &symbols, ColliderArena &arena,
+              int lineNum) override {
+        int resolution;
+        if (!line.number(resolution) || resolution <= 0) {
+            printf("Error: Failed to parse support map resolution, line %d.\n", lineNum);
+            return false;
+        }
+        vector<vec3> points;
+        if (!loadPoints(line, points, lineNum)) return false;
+
+        MappedPointsCollider3D *collider = arena.make<MappedPointsCollider3D>();
+        collider->setPoints(points);
+        chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+        collider->buildMap(resolution);
+        double millis = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+        printf("Built support map on line %d: %d cells, %.1f candidates per cell, %.1fKB in %.2fms.\n",
+               lineNum, int(collider->cellStart.size() - 1),
+               double(collider->candidates.size()) / (collider->cellStart.size() - 1),
+               collider->mapBytes() / 1024.0, millis);
+        symbol.value = collider;
+        return true;
+    }
+};
+
+struct PointsFileLoader : public Loader {
+    bool load(ConfigTokens &line, Symbol &symbol, const SymbolTable &symbols, ColliderArena &arena,
+              int lineNum) override {
+        std::string path;
+        if (!line.word(path)) {
+            printf("Error: Not enough tokens for points_file, line %d.\n", lineNum);
+            return false;
         }
-        if (collider->points.size() == 0) {
+        // The collider scans the mapping in place, so the file stays mapped for as long as the collider lives.
+        chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+        PointsFile *file = arena.make<PointsFile>();
+        if (!file->open(path.c_str())) {
+            printf("Error: Failed to open points file '%s', line %d.\n", path.c_str(), lineNum);
+            return false;
+        }
+        if (file->header->count == 0) {
             printf("Error: Empty point collider, line %d.\n", lineNum);
+            file->close();
+            return false;
+        }
+        PointViewCollider3D *collider = arena.make<PointViewCollider3D>();
+        file->view(collider);
+        double millis = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+        printf("Mapped %d points from '%s' on line %d in %.2fms.\n", int(collider->count), path.c_str(), lineNum, millis);
+        symbol.value = collider;
+        return true;
+    }
+};
+
+struct BakeLoader : public Loader {
+    // The cache settings of the config being loaded, which baked hulls share with the object's.
+    string cacheDirectory;
+    size_t cacheBytes = 0;
+    bool exact = false;
+
+    bool load(ConfigTokens &line, Symbol &symbol, const SymbolTable &symbols, ColliderArena &arena,
+              int lineNum) override {
+        std::string name;
+        float epsilon;
+        if (!(line.word(name) && line.number(epsilon))) {
+            printf("Error: Not enough tokens for bake, line %d.\n", lineNum);
+            return false;
+        }
+        const Symbol *target = symbols.find(name);
+        if (!target) {
+            printf("Error: Unknown symbol %s, line %d.\n", name.c_str(), lineNum);
+            return false;
+        }
+
+        // Spheres are kept out of the hull and added back exactly.
+        chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+        SurfaceState state;
+        state.object = target->value;
+        state.epsilon = epsilon;
+        state.splitMargin = true;
+        state.cacheDirectory = cacheDirectory;
+        state.cacheBytes = cacheBytes;
+        state.exact = exact;
+        if (!finishHull(&state)) {
+            printf("Error: Hull of %s is too detailed to bake at epsilon %f, line %d.\n", name.c_str(), epsilon, lineNum);
             return false;
         }
+        BakedHullCollider3D baked;
+        if (!baked.bake(state)) {
+            printf("Error: Can't bake %s, it is flat, line %d.\n", name.c_str(), lineNum);
+            return false;
+        }
+        BakedHullCollider3D *collider = arena.make<BakedHullCollider3D>(std::move(baked));
+        double millis = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+        printf("Baked %s on line %d into %d vertices within %g in %.2fms.\n",
+               name.c_str(), lineNum, int(collider->vertices.size()), collider->epsilon, millis);
         symbol.value = collider;
         return true;
     }
@@ -125,79 +316,235 @@ static SphereLoader sphereLoader;
 static PointLoader pointLoader;
 static AddLoader addLoader;
 static SubLoader subLoader;
+static SweepLoader sweepLoader;
 static PointsLoader pointsLoader;
+static ClusteredLoader clusteredLoader;
+static MappedLoader mappedLoader;
+static PointsFileLoader pointsFileLoader;
+static BakeLoader bakeLoader;
 
 Loader *findLoader(const string &type) {
     if (type == "sphere") return &sphereLoader;
     if (type == "point") return &pointLoader;
     if (type == "add") return &addLoader;
     if (type == "sub") return &subLoader;
+    if (type == "sweep") return &sweepLoader;
     if (type == "points") return &pointsLoader;
+    if (type == "clustered") return &clusteredLoader;
+    if (type == "mapped") return &mappedLoader;
+    if (type == "points_file") return &pointsFileLoader;
+    if (type == "bake") return &bakeLoader;
     return nullptr;
 }
 
-bool load(const char *filename, SurfaceState *state) {
-    ifstream file(filename);
-    if (!file) {
+// Symbols referenced by this many add and sub lines or more are reported, since every path to them multiplies their cost
+// in a query without memoization.
+static const int kHighFanOut = 4;
+
+// The config describes a DAG, but queries walk it as a tree, so a symbol used by several colliders would be evaluated
+// again on every path to it. Those symbols are wrapped in SharedCollider3D, which evaluates them once per direction.
+// Points and spheres are cheaper than the memo, so they are left alone.
+static void shareSymbols(vector<Symbol> &symbols, ColliderArena &arena) {
+    unordered_map<Collider3D *, int> fanOut;
+    for (Symbol &symbol : symbols) {
+        if (AddCollider3D *add = dynamic_cast<AddCollider3D *>(symbol.value)) {
+            fanOut[add->a]++;
+            fanOut[add->b]++;
+        } else if (SubCollider3D *sub = dynamic_cast<SubCollider3D *>(symbol.value)) {
+            fanOut[sub->a]++;
+            fanOut[sub->b]++;
+        } else if (SweptCollider3D *swept = dynamic_cast<SweptCollider3D *>(symbol.value)) {
+            fanOut[swept->inner]++;
+        }
+    }
+
+    unordered_map<Collider3D *, Collider3D *> shared;
+    for (Symbol &symbol : symbols) {
+        int references = fanOut[symbol.value];
+        if (references >= kHighFanOut) {
+            printf("Warning: Symbol '%s' on line %d has a high fan-out, it is referenced %d times.\n",
+                   symbol.name.c_str(), symbol.lineNum, references);
+        }
+        if (references < 2 || dynamic_cast<PointCollider3D *>(symbol.value) ||
+            dynamic_cast<SphereCollider3D *>(symbol.value)) {
+            continue;
+        }
+        shared[symbol.value] = arena.make<SharedCollider3D>(symbol.value);
+        printf("Sharing the support queries of symbol '%s' between its %d references.\n",
+               symbol.name.c_str(), references);
+    }
+    if (shared.empty()) return;
+
+    auto share = [&](Collider3D *&child) {
+        auto found = shared.find(child);
+        if (found != shared.end()) child = found->second;
+    };
+    for (Symbol &symbol : symbols) {
+        if (AddCollider3D *add = dynamic_cast<AddCollider3D *>(symbol.value)) {
+            share(add->a);
+            share(add->b);
+        } else if (SubCollider3D *sub = dynamic_cast<SubCollider3D *>(symbol.value)) {
+            share(sub->a);
+            share(sub->b);
+        } else if (SweptCollider3D *swept = dynamic_cast<SweptCollider3D *>(symbol.value)) {
+            share(swept->inner);
+        }
+    }
+}
+
+// Loads the symbols of a config, and the special identifiers into state. Bodies are added to scene, or skipped if it is
+// null. Reports whether epsilon and object were given.
+static bool loadConfig(const char *filename, SurfaceState *state, Scene3D *scene, ColliderArena *arena,
+                       bool *hasEpsilon, bool *hasObject) {
+    // Big point clouds make configs hundreds of megabytes, so lines are tokenized in place in the mapped file rather
+    // than copied into strings and streams.
+    MappedFile file;
+    if (!file.open(filename)) {
         printf("Failed to open file '%s'.\n", filename);
         return false;
     }
 
-    vector<Symbol> symbols;
-    bool hasEpsilon = false;
-    bool hasObject = false;
+    SymbolTable symbols;
+    bakeLoader.cacheDirectory.clear();
+    *hasEpsilon = false;
+    *hasObject = false;
+    bool parallel = false;
 
     int lineNum = 0;
-    string line;
     string token;
-    while (getline(file, line)) {
+    const char *end = file.data() + file.size();
+    for (const char *line = file.data(), *next; line != end; line = next) {
+        const char *lineEnd = static_cast<const char *>(memchr(line, '\n', size_t(end - line)));
+        next = lineEnd ? lineEnd + 1 : end;
+        if (!lineEnd) lineEnd = end;
         lineNum++;
-        if (line.empty() || line[0] == '#') continue;
+        if (line == lineEnd || line[0] == '#') continue;
 
-        istringstream tokens(line);
-        tokens >> token;
+        ConfigTokens tokens(line, lineEnd);
+        if (!tokens.word(token)) continue;
 
         if (token == "epsilon") {
-            if (!(tokens >> state->epsilon)) {
+            if (!tokens.number(state->epsilon)) {
                 printf("Error: Failed to parse epsilon, line %d.\n", lineNum);
             } else {
-                hasEpsilon = true;
+                *hasEpsilon = true;
+            }
+            continue;
+        }
+
+        if (token == "margin") {
+            int split;
+            if (!tokens.number(split)) {
+                printf("Error: Failed to parse margin, line %d.\n", lineNum);
+            } else {
+                state->splitMargin = split != 0;
             }
             continue;
         }
 
-        if (findSymbol(symbols, token)) {
+        if (token == "exact") {
+            int exact;
+            if (!tokens.number(exact)) {
+                printf("Error: Failed to parse exact, line %d.\n", lineNum);
+            } else {
+                state->exact = exact != 0;
+                bakeLoader.exact = state->exact;
+            }
+            continue;
+        }
+
+        if (token == "cache") {
+            float megabytes = 64;
+            if (!tokens.word(state->cacheDirectory)) {
+                printf("Error: Failed to parse cache, line %d.\n", lineNum);
+            } else {
+                if (tokens.number(megabytes)) state->cacheBytes = size_t(megabytes * (1 << 20));
+                bakeLoader.cacheDirectory = state->cacheDirectory;
+                bakeLoader.cacheBytes = state->cacheBytes;
+            }
+            continue;
+        }
+
+        if (token == "parallel") {
+            int enable;
+            if (!tokens.number(enable)) {
+                printf("Error: Failed to parse parallel, line %d.\n", lineNum);
+            } else {
+                parallel = enable != 0;
+            }
+            continue;
+        }
+
+        if (token == "body") {
+            string name, shape;
+            vec3 position, rotation = vec3(0);
+            if (!(tokens.word(name) && tokens.word(shape) && tokens.number(position.x) && tokens.number(position.y) &&
+                  tokens.number(position.z))) {
+                printf("Error: Failed to parse body, line %d.\n", lineNum);
+                continue;
+            }
+            // The rotation is optional, but all or nothing.
+            if (tokens.number(rotation.x) && !(tokens.number(rotation.y) && tokens.number(rotation.z))) {
+                printf("Error: Failed to parse body rotation, line %d.\n", lineNum);
+                continue;
+            }
+            const Symbol *symbol = symbols.find(shape);
+            if (!symbol) {
+                printf("Error: Unknown symbol %s, line %d.\n", shape.c_str(), lineNum);
+                continue;
+            }
+            if (scene) {
+                scene->add(name, symbol->value, axisAngleRotation(rotation), position);
+            } else {
+                printf("Warning: Ignoring body %s outside of a scene, line %d.\n", name.c_str(), lineNum);
+            }
+            continue;
+        }
+
+        if (symbols.find(token)) {
             printf("Error: Duplicate token '%s' on line %d.\n", token.c_str(), lineNum);
             continue;
         }
 
-        symbols.emplace_back();
-        Symbol &symbol = symbols.back();
+        Symbol symbol;
         symbol.name = token;
-        if (!(tokens >> token)) {
+        symbol.lineNum = lineNum;
+        if (!tokens.word(token)) {
             printf("Error: No type on line %d.\n", lineNum);
-            symbols.pop_back();
             continue;
         }
 
         Loader *loader = findLoader(token);
         if (!loader) {
             printf("Error: No loader found for type %s, line %d.\n", token.c_str(), lineNum);
-            symbols.pop_back();
             continue;
         }
 
-        if (!loader->load(tokens, symbol, symbols, lineNum)) {
-            symbols.pop_back();
-            continue;
-        }
+        if (!loader->load(tokens, symbol, symbols, *arena, lineNum)) continue;
+        symbols.add(symbol);
 
         if (symbol.name == "object") {
             state->object = symbol.value;
-            hasObject = true;
+            *hasObject = true;
+        }
+    }
+
+    for (Symbol &symbol : symbols.symbols) {
+        if (PointHullCollider3D *points = dynamic_cast<PointHullCollider3D *>(symbol.value)) {
+            points->parallel = parallel;
+        } else if (PointViewCollider3D *view = dynamic_cast<PointViewCollider3D *>(symbol.value)) {
+            view->parallel = parallel;
         }
     }
 
+    shareSymbols(symbols.symbols, *arena);
+    return true;
+}
+
+bool load(const char *filename, SurfaceState *state, ColliderArena *arena) {
+    bool hasEpsilon, hasObject;
+    if (!loadConfig(filename, state, nullptr, arena, &hasEpsilon, &hasObject)) return false;
+
     if (!hasEpsilon) {
         printf("Error: No epsilon specified.\n");
         return false;
@@ -207,6 +554,18 @@ bool load(const char *filename, SurfaceState *state) {
         printf("Error: No object specified.\n");
         return false;
     }
+    return true;
+}
 
+bool loadScene(const char *filename, Scene3D *scene, ColliderArena *arena) {
+    SurfaceState settings;
+    bool hasEpsilon, hasObject;
+    size_t before = scene->objects().size();
+    if (!loadConfig(filename, &settings, scene, arena, &hasEpsilon, &hasObject)) return false;
+
+    if (scene->objects().size() == before) {
+        printf("Error: No bodies specified.\n");
+        return false;
+    }
     return true;
 }
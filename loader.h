@@ -6,7 +6,15 @@
 #define MINKOWSKIHULL3D_LOADER_H
 
 struct SurfaceState;
+class ColliderArena;
 
-bool load(const char *filename, SurfaceState *state);
+// Loads a config into state. The colliders are made in arena, which must outlive every use of state's object.
+bool load(const char *filename, SurfaceState *state, ColliderArena *arena);
+
+class Scene3D;
+
+// Loads the bodies of a config into scene, which need no object or epsilon. The colliders are made in arena, which must
+// outlive the scene.
+bool loadScene(const char *filename, Scene3D *scene, ColliderArena *arena);
 
 #endif //MINKOWSKIHULL3D_LOADER_H
@@ -10,7 +10,11 @@
 #include "gl_includes.h"
 #include "Perf.h"
 #include "hull3D.h"
+#include "gaussMap3D.h"
+#include "hullCache3D.h"
+#include "hullFile3D.h"
 #include "loader.h"
+#include "colliderArena.h"
 
 using namespace std;
 using namespace glm;
@@ -70,7 +74,9 @@ SphereCollider3D sphere;
 PointHullCollider3D points;
 AddCollider3D combined;
 
+ColliderArena colliders; // owns the colliders loaded from the config
 SurfaceState state;
+HullCacheKey cacheKey;
 
 int numVerts;
 
@@ -80,6 +86,13 @@ struct Vertex {
     vec3 color;
 };
 
+// Steps the state, and stores the hull in the cache once it is finished.
+void stepState() {
+    if (state.done()) return;
+    state.step();
+    if (state.done()) storeCachedHull(state, cacheKey);
+}
+
 void dumpState() {
     printf("Points:\n");
     for (int c = 0, n = state.points.size(); c < n; c++) {
@@ -97,7 +110,8 @@ void dumpState() {
                tri.edges[2].opposite / 4, tri.edges[2].opposite & 3);
     }
 
-    printf("\nCurrent: %d\n\n", state.current);
+    printf("\nCurrent: %d\n", state.current);
+    printf("Margin: %f\n\n", state.margin);
 }
 
 const vec3 kOutsideColor = vec3(1, 0.5, 0);
@@ -173,26 +187,32 @@ void setup() {
     view = lookAt(vec3(0, 0, 5), vec3(0), vec3(0, 1, 0));
     rotation = lookAt(vec3(0), vec3(-1), vec3(0, 1, 0));
 
-    if (!load("assets/config.txt", &state)) {
+    if (!load("assets/config.txt", &state, &colliders)) {
         printf("Failed to load config.txt, using default collider instead.\n");
         sphere.radius = 0.3;
-        points.points.emplace_back(0, -1.7, 0);
-        points.points.emplace_back(0, 1.7, 0);
-        points.points.emplace_back(1, 0, 1);
-        points.points.emplace_back(-1, 0, 1);
+        points.setPoints({vec3(0, -1.7, 0), vec3(0, 1.7, 0), vec3(1, 0, 1), vec3(-1, 0, 1)});
         combined.a = &sphere;
         combined.b = &points;
         state.object = &combined;
         state.epsilon = 0.001;
     }
-    state.init();
+    cacheKey = hullCacheKey(state);
+    if (loadCachedHull(&state, cacheKey)) {
+        printf("Loaded the finished hull from the cache, %d triangles.\n", int(state.triangles.size()));
+    } else if (state.exact && buildExactHull(&state)) {
+        printf("Object is a polytope, built its exact hull with %d triangles.\n", int(state.triangles.size()));
+        storeCachedHull(state, cacheKey);
+    } else {
+        state.init();
+    }
+    if (state.splitMargin) printf("Hulling the core only, margin is %f.\n", state.margin);
     updateMesh();
 }
 
 void draw() {
     if (animationStepsLeft > 0) {
         if (animationFramesLeft <= 0) {
-            state.step();
+            stepState();
             updateMesh();
             animationFramesLeft = animationFrameReset;
             animationStepsLeft--;
@@ -245,7 +265,7 @@ static void glfw_key_callback(GLFWwindow* window, int key, int scancode, int act
         if (mods & GLFW_MOD_SHIFT) {
             animationStepsLeft = 15;
         } else {
-            state.step();
+            stepState();
             updateMesh();
         }
     } else if (key == GLFW_KEY_A) {
@@ -255,6 +275,10 @@ static void glfw_key_callback(GLFWwindow* window, int key, int scancode, int act
         animationFramesLeft = 0;
     } else if (key == GLFW_KEY_D) {
         dumpState();
+    } else if (key == GLFW_KEY_E) {
+        if (writeHullFile("output.hull", state, HULL_FILE_PLANES | HULL_FILE_ADJACENCY)) {
+            printf("Wrote the hull to output.hull.\n");
+        }
     }
 }
 
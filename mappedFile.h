@@ -0,0 +1,46 @@
+//
+// Read only memory mapped files.
+//
+
+#ifndef MINKOWSKIHULL3D_MAPPEDFILE_H
+#define MINKOWSKIHULL3D_MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Maps a whole file into memory for reading. The pages are loaded lazily by the OS and shared with its file cache,
+// so nothing is copied. The mapping lasts until close() or destruction.
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Returns false if the file can't be opened. An empty file opens, with a null data pointer.
+    bool open(const char *path);
+    void close();
+
+    const char *data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char *bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void *file = nullptr;
+    void *mapping = nullptr;
+#endif
+};
+
+// Whether this machine stores values little endian. The mapped binary formats are defined as little endian and used in
+// place, so they can only be written and read where this holds.
+inline bool hostIsLittleEndian() {
+    const uint32_t one = 1;
+    unsigned char first;
+    memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+#endif //MINKOWSKIHULL3D_MAPPEDFILE_H
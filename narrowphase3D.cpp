@@ -0,0 +1,100 @@
+//
+// Narrowphase queries on many pairs of colliders at once, split across threads.
+//
+
+#include <algorithm>
+
+#include "narrowphase3D.h"
+#include "workerPool.h"
+
+using namespace std;
+using namespace glm;
+
+void PairBatch3D::clear() {
+    a.clear();
+    b.clear();
+}
+
+void PairBatch3D::add(Collider3D *first, Collider3D *second) {
+    a.push_back(first);
+    b.push_back(second);
+}
+
+void PairBatchResults3D::resize(size_t count) {
+    overlap.resize(count);
+    separation.resize(count);
+    normalX.resize(count);
+    normalY.resize(count);
+    normalZ.resize(count);
+    witnessAX.resize(count);
+    witnessAY.resize(count);
+    witnessAZ.resize(count);
+    witnessBX.resize(count);
+    witnessBY.resize(count);
+    witnessBZ.resize(count);
+    supportCalls.resize(count);
+}
+
+// Kept per thread, since a pool's threads outlive any one batch.
+static thread_local EpaScratch epaScratch;
+
+static void storePair(PairBatchResults3D *results, size_t c, bool overlap, float separation, vec3 normal,
+                      vec3 witnessA, vec3 witnessB, int supportCalls) {
+    results->overlap[c] = overlap;
+    results->separation[c] = separation;
+    results->normalX[c] = normal.x;
+    results->normalY[c] = normal.y;
+    results->normalZ[c] = normal.z;
+    results->witnessAX[c] = witnessA.x;
+    results->witnessAY[c] = witnessA.y;
+    results->witnessAZ[c] = witnessA.z;
+    results->witnessBX[c] = witnessB.x;
+    results->witnessBY[c] = witnessB.y;
+    results->witnessBZ[c] = witnessB.z;
+    results->supportCalls[c] = supportCalls;
+}
+
+static void queryPair(Collider3D *a, Collider3D *b, PairQuery query, float epsilon, PairBatchResults3D *results,
+                      size_t c) {
+    if (query == PAIR_OVERLAP) {
+        GjkStats stats;
+        bool overlap = gjkIntersect(a, b, &stats);
+        storePair(results, c, overlap, 0, vec3(0), vec3(0), vec3(0), stats.supportCalls);
+        return;
+    }
+
+    DistanceResult distance;
+    if (gjkDistance(a, b, &distance)) {
+        vec3 normal = distance.distance > 0 ? (distance.witnessB - distance.witnessA) / distance.distance : vec3(0);
+        storePair(results, c, false, distance.distance, normal, distance.witnessA, distance.witnessB,
+                  distance.supportCalls);
+        return;
+    }
+    if (query == PAIR_DISTANCE) {
+        storePair(results, c, true, 0, vec3(0), vec3(0), vec3(0), distance.supportCalls);
+        return;
+    }
+
+    // The depth is found from scratch, since EPA needs GJK's enclosing simplex rather than its closest feature.
+    PenetrationResult penetration;
+    bool overlap = epaPenetration(a, b, epsilon, &penetration, &epaScratch);
+    storePair(results, c, overlap, -penetration.depth, penetration.normal, penetration.witnessA, penetration.witnessB,
+              distance.supportCalls + penetration.supportCalls);
+}
+
+void queryPairs(const PairBatch3D &pairs, PairQuery query, float epsilon, PairBatchResults3D *results) {
+    queryPairs(pairs, query, epsilon, results, sharedWorkerPool());
+}
+
+void queryPairs(const PairBatch3D &pairs, PairQuery query, float epsilon, PairBatchResults3D *results,
+                WorkerPool &pool) {
+    size_t count = pairs.size();
+    results->resize(count);
+    size_t blocks = (count + kPairBlockSize - 1) / kPairBlockSize;
+    pool.parallelFor(blocks, [&](size_t block) {
+        size_t end = std::min(count, (block + 1) * kPairBlockSize);
+        for (size_t c = block * kPairBlockSize; c < end; c++) {
+            queryPair(pairs.a[c], pairs.b[c], query, epsilon, results, c);
+        }
+    });
+}
@@ -0,0 +1,59 @@
+//
+// Narrowphase queries on many pairs of colliders at once, split across threads.
+//
+
+#ifndef MINKOWSKIHULL3D_NARROWPHASE3D_H
+#define MINKOWSKIHULL3D_NARROWPHASE3D_H
+
+#include <vector>
+
+#include "epa3D.h"
+
+class WorkerPool;
+
+enum PairQuery {
+    PAIR_OVERLAP, // only whether the pair overlaps, by gjkIntersect
+    PAIR_DISTANCE, // the distance and closest points of separated pairs, by gjkDistance
+    PAIR_CONTACT, // PAIR_DISTANCE, and the penetration of overlapping pairs by epaPenetration
+};
+
+// The pairs to query, as the two colliders of each. Queries only read them, so a collider can be in many pairs.
+struct PairBatch3D {
+    std::vector<Collider3D *> a, b;
+
+    size_t size() const { return a.size(); }
+    void clear();
+    void add(Collider3D *first, Collider3D *second);
+};
+
+// The results of a batch, one per pair, stored as separate arrays. Fields a query doesn't compute are left at 0.
+// Keeping the same results between batches reuses the arrays, so a batch no bigger than the last allocates nothing.
+struct PairBatchResults3D {
+    std::vector<uint8_t> overlap; // 1 if the pair overlaps or touches
+    // The distance between separated pairs, or minus the depth of overlapping ones, for PAIR_CONTACT.
+    std::vector<float> separation;
+    // The unit direction from a to b, along which moving b by -separation makes the pair touch.
+    std::vector<float> normalX, normalY, normalZ;
+    // The closest points of separated pairs, or the deepest points of overlapping ones. See PenetrationResult.
+    std::vector<float> witnessAX, witnessAY, witnessAZ;
+    std::vector<float> witnessBX, witnessBY, witnessBZ;
+    std::vector<int> supportCalls;
+
+    size_t size() const { return overlap.size(); }
+    void resize(size_t count);
+};
+
+// Pairs are handed out to threads in blocks of this many, small enough to balance the load when the cost of pairs
+// varies a lot, and big enough that taking a block costs little next to querying it.
+const size_t kPairBlockSize = 32;
+
+// Runs query on every pair of the batch, in blocks split across the pool, or sharedWorkerPool(). Each thread keeps its
+// own EPA buffers, and the colliders need no wrapping, so the queries allocate nothing once the buffers have grown.
+// Every pair gets exactly the result of querying it alone, whatever the number of threads. The colliders' findSupport
+// must be safe to call from several threads, which it is for all the colliders here.
+// epsilon is the depth tolerance of epaPenetration.
+void queryPairs(const PairBatch3D &pairs, PairQuery query, float epsilon, PairBatchResults3D *results);
+void queryPairs(const PairBatch3D &pairs, PairQuery query, float epsilon, PairBatchResults3D *results,
+                WorkerPool &pool);
+
+#endif //MINKOWSKIHULL3D_NARROWPHASE3D_H
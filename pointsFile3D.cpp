@@ -0,0 +1,102 @@
+//
+// A binary point cloud format that can be memory mapped and scanned in place.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "pointsFile3D.h"
+
+using namespace std;
+using namespace glm;
+
+static_assert(sizeof(PointsFileHeader) == 48, "The points file header must have no padding.");
+
+static const char kPointsFileMagic[4] = {'M', 'K', 'P', 'C'};
+static const uint64_t kArrayAlignment = 64; // a cache line, and the widest vector load
+
+static uint64_t align(uint64_t offset) {
+    return (offset + kArrayAlignment - 1) / kArrayAlignment * kArrayAlignment;
+}
+
+bool writePointsFile(const char *path, const vector<vec3> &points) {
+    if (!hostIsLittleEndian()) return false;
+    PointsFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kPointsFileMagic, 4);
+    header.version = kPointsFileVersion;
+    header.count = points.size();
+    header.padded = (points.size() + kSupportScanLanes - 1) / kSupportScanLanes * kSupportScanLanes;
+    uint64_t arrayBytes = header.padded * sizeof(float);
+    header.xs = align(sizeof(header));
+    header.ys = align(header.xs + arrayBytes);
+    header.zs = align(header.ys + arrayBytes);
+
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    uint64_t written = sizeof(header);
+
+    // Written in blocks, so a huge cloud doesn't need a second copy in memory.
+    static const char zeros[kArrayAlignment] = {};
+    const uint64_t offsets[3] = {header.xs, header.ys, header.zs};
+    vector<float> block;
+    for (int axis = 0; axis < 3 && ok; axis++) {
+        ok = fwrite(zeros, 1, size_t(offsets[axis] - written), file) == offsets[axis] - written;
+        for (size_t begin = 0; begin < header.padded && ok; begin += 1 << 16) {
+            size_t end = std::min<size_t>(begin + (1 << 16), header.padded);
+            block.clear();
+            for (size_t c = begin; c < end; c++) block.push_back(points[c < header.count ? c : header.count - 1][axis]);
+            ok = fwrite(block.data(), sizeof(float), block.size(), file) == block.size();
+        }
+        written = offsets[axis] + arrayBytes;
+    }
+    if (fclose(file) != 0) ok = false;
+    if (!ok) remove(path);
+    return ok;
+}
+
+vector<vec3> PointViewCollider3D::points() const {
+    vector<vec3> points;
+    points.reserve(count);
+    for (size_t c = 0; c < count; c++) points.push_back(point(c));
+    return points;
+}
+
+bool PointsFile::open(const char *path) {
+    close();
+    if (!hostIsLittleEndian() || !file.open(path)) return false;
+    if (file.size() < sizeof(PointsFileHeader)) {
+        file.close();
+        return false;
+    }
+    const PointsFileHeader *h = reinterpret_cast<const PointsFileHeader *>(file.data());
+    uint64_t size = file.size();
+    bool valid = memcmp(h->magic, kPointsFileMagic, 4) == 0 && h->version == kPointsFileVersion &&
+                 h->padded >= h->count && h->padded - h->count < kSupportScanLanes && (h->count > 0 || h->padded == 0) &&
+                 h->padded <= size / sizeof(float);
+    for (uint64_t offset : {h->xs, h->ys, h->zs}) {
+        valid = valid && offset % sizeof(float) == 0 && offset >= sizeof(PointsFileHeader) && offset <= size &&
+                h->padded * sizeof(float) <= size - offset;
+        // A padding copy that beat the last point would be returned as the support, past the end of the points.
+        const float *values = reinterpret_cast<const float *>(file.data() + (valid ? offset : 0));
+        for (uint64_t c = h->count; valid && c < h->padded; c++) {
+            valid = memcmp(&values[c], &values[h->count - 1], sizeof(float)) == 0;
+        }
+    }
+    if (!valid) {
+        file.close();
+        return false;
+    }
+    header = h;
+    return true;
+}
+
+void PointsFile::view(PointViewCollider3D *collider) const {
+    collider->xs = reinterpret_cast<const float *>(file.data() + header->xs);
+    collider->ys = reinterpret_cast<const float *>(file.data() + header->ys);
+    collider->zs = reinterpret_cast<const float *>(file.data() + header->zs);
+    collider->count = size_t(header->count);
+    collider->padded = size_t(header->padded);
+}
@@ -0,0 +1,67 @@
+//
+// A binary point cloud format that can be memory mapped and scanned in place.
+//
+
+#ifndef MINKOWSKIHULL3D_POINTSFILE3D_H
+#define MINKOWSKIHULL3D_POINTSFILE3D_H
+
+#include "hull3D.h"
+#include "mappedFile.h"
+
+// Bump whenever the layout changes. Readers reject other versions.
+const uint32_t kPointsFileVersion = 1;
+
+// The file starts with this header. The points follow as separate coordinate arrays, laid out exactly like
+// PointHullCollider3D's: each padded to a multiple of kSupportScanLanes by repeating the last point, and starting at a
+// multiple of 64 bytes. All values are little endian, so the scan kernels can run on a mapped file directly. Big endian
+// machines can't use them in place, so they neither write nor open points files.
+struct PointsFileHeader {
+    char magic[4]; // "MKPC"
+    uint32_t version;
+    uint64_t count;
+    uint64_t padded; // the length of each array
+    uint64_t xs, ys, zs; // float[padded] each
+};
+
+// Writes points to path. Returns false if the file can't be written, or if this machine is big endian.
+bool writePointsFile(const char *path, const std::vector<glm::vec3> &points);
+
+// Scans points it doesn't own, like those of a mapped points file, which must outlive it.
+// Returns exactly the same points as a PointHullCollider3D holding copies of them.
+struct PointViewCollider3D : public Collider3D {
+    const float *xs = nullptr, *ys = nullptr, *zs = nullptr;
+    size_t count = 0;
+    size_t padded = 0; // the length of the arrays
+    bool parallel = false; // opt in to splitting scans of kMinParallelScanPoints or more across threads
+
+    std::vector<glm::vec3> points() const;
+    glm::vec3 point(size_t index) const { return glm::vec3(xs[index], ys[index], zs[index]); }
+
+    size_t findSupportIndex(glm::vec3 direction) const {
+        return pointsSupportScan(xs, ys, zs, padded, direction, parallel);
+    }
+
+    glm::vec3 findSupport(glm::vec3 direction) override {
+        if (count == 0) return glm::vec3(0);
+        return point(findSupportIndex(direction));
+    }
+};
+
+// A mapped points file. Opening only reads the header and the padding at the end of each array, checking that the
+// arrays fit in the file and that the padding repeats the last point, so the scans never return a padding index.
+// Nothing is parsed or copied, and the other pages are read in by the first scans that touch them.
+class PointsFile {
+public:
+    bool open(const char *path);
+    void close() { file.close(); header = nullptr; }
+
+    const PointsFileHeader *header = nullptr;
+
+    // Points collider at the mapped points. It is valid until the file is closed.
+    void view(PointViewCollider3D *collider) const;
+
+private:
+    MappedFile file;
+};
+
+#endif //MINKOWSKIHULL3D_POINTSFILE3D_H
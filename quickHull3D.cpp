@@ -0,0 +1,308 @@
+//
+// Convex hulls of point sets, by quickhull.
+//
+
+#include <algorithm>
+#include <cfloat>
+#include <thread>
+
+#include "quickHull3D.h"
+
+using namespace std;
+using namespace glm;
+
+static const size_t kMinPointsPerThread = 1 << 14; // below this, starting a thread costs more than it saves
+
+struct HullFace {
+    uint32_t v[3];
+    uint32_t neighbor[3]; // the face across the edge from v[c] to v[c + 1]
+    vec3 normal;
+    float offset;
+    vector<uint32_t> outside; // points above this face, which still need to be hulled
+    uint32_t visit = 0;
+    bool alive = true;
+};
+
+struct HorizonEdge {
+    uint32_t face; // the visible face
+    int edge;
+};
+
+struct QuickHull {
+    const vec3 *points;
+    uint32_t count;
+    float tolerance;
+    vector<HullFace> faces;
+
+    uint32_t stamp = 0;
+    vector<uint32_t> visible;
+    vector<HorizonEdge> horizon;
+
+    QuickHull(const vec3 *points, uint32_t count) : points(points), count(count) {
+        vec3 extent = vec3(0);
+        for (uint32_t c = 0; c < count; c++) extent = max(extent, abs(points[c]));
+        tolerance = 3 * FLT_EPSILON * (extent.x + extent.y + extent.z);
+    }
+
+    float distance(const HullFace &face, uint32_t point) const {
+        return dot(face.normal, points[point]) - face.offset;
+    }
+
+    uint32_t addFace(uint32_t a, uint32_t b, uint32_t c) {
+        faces.emplace_back();
+        HullFace &face = faces.back();
+        face.v[0] = a;
+        face.v[1] = b;
+        face.v[2] = c;
+        vec3 normal = cross(points[b] - points[a], points[c] - points[a]);
+        float len = length(normal);
+        face.normal = len > 0 ? normal / len : vec3(0);
+        face.offset = dot(face.normal, points[a]);
+        return uint32_t(faces.size() - 1);
+    }
+
+    // Puts the point on the outside list of the face it is furthest above, if it is above any of them.
+    void assign(uint32_t point, uint32_t firstFace) {
+        float best = tolerance;
+        uint32_t bestFace = uint32_t(-1);
+        for (uint32_t f = firstFace, n = uint32_t(faces.size()); f < n; f++) {
+            if (!faces[f].alive) continue;
+            float d = distance(faces[f], point);
+            if (d > best) {
+                best = d;
+                bestFace = f;
+            }
+        }
+        if (bestFace != uint32_t(-1)) faces[bestFace].outside.push_back(point);
+    }
+
+    bool initSimplex() {
+        if (count < 4) return false;
+
+        uint32_t extremes[6] = {0, 0, 0, 0, 0, 0};
+        for (uint32_t c = 0; c < count; c++) {
+            for (int axis = 0; axis < 3; axis++) {
+                if (points[c][axis] < points[extremes[axis * 2]][axis]) extremes[axis * 2] = c;
+                if (points[c][axis] > points[extremes[axis * 2 + 1]][axis]) extremes[axis * 2 + 1] = c;
+            }
+        }
+
+        // The two extremes furthest apart, then the point furthest from their line, then from their plane.
+        uint32_t simplex[4] = {0, 0, 0, 0};
+        float best = -1;
+        for (int c = 0; c < 6; c++) {
+            for (int d = c + 1; d < 6; d++) {
+                vec3 delta = points[extremes[d]] - points[extremes[c]];
+                if (dot(delta, delta) > best) {
+                    best = dot(delta, delta);
+                    simplex[0] = extremes[c];
+                    simplex[1] = extremes[d];
+                }
+            }
+        }
+
+        vec3 base = points[simplex[0]];
+        vec3 line = points[simplex[1]] - base;
+        best = 0;
+        for (uint32_t c = 0; c < count; c++) {
+            vec3 off = cross(points[c] - base, line);
+            if (dot(off, off) > best) {
+                best = dot(off, off);
+                simplex[2] = c;
+            }
+        }
+        if (best <= 0) return false;
+
+        vec3 normal = normalize(cross(line, points[simplex[2]] - base));
+        best = 0;
+        for (uint32_t c = 0; c < count; c++) {
+            float d = abs(dot(points[c] - base, normal));
+            if (d > best) {
+                best = d;
+                simplex[3] = c;
+            }
+        }
+        if (best <= tolerance) return false;
+
+        // Orient every face away from the vertex it doesn't use.
+        static const int kFaceVerts[4][4] = {{0, 1, 2, 3}, {0, 1, 3, 2}, {0, 2, 3, 1}, {1, 2, 3, 0}};
+        for (const int *verts : kFaceVerts) {
+            uint32_t a = simplex[verts[0]], b = simplex[verts[1]], c = simplex[verts[2]];
+            vec3 pa = points[a];
+            if (dot(cross(points[b] - pa, points[c] - pa), points[simplex[verts[3]]] - pa) > 0) swap(b, c);
+            addFace(a, b, c);
+        }
+        for (HullFace &face : faces) {
+            for (int c = 0; c < 3; c++) {
+                for (uint32_t other = 0; other < 4; other++) {
+                    for (int d = 0; d < 3; d++) {
+                        if (faces[other].v[d] == face.v[(c + 1) % 3] && faces[other].v[(d + 1) % 3] == face.v[c]) {
+                            face.neighbor[c] = other;
+                        }
+                    }
+                }
+            }
+        }
+
+        for (uint32_t c = 0; c < count; c++) {
+            if (c == simplex[0] || c == simplex[1] || c == simplex[2] || c == simplex[3]) continue;
+            assign(c, 0);
+        }
+        return true;
+    }
+
+    // Finds the faces visible from the eye, and the loop of edges around them in counterclockwise order.
+    void findHorizon(uint32_t start, uint32_t eye) {
+        struct Frame {
+            uint32_t face;
+            int first;
+            int step;
+        };
+        vector<Frame> stack;
+
+        stamp++;
+        visible.clear();
+        horizon.clear();
+        faces[start].visit = stamp;
+        visible.push_back(start);
+        stack.push_back({start, 0, 0});
+        while (!stack.empty()) {
+            Frame &frame = stack.back();
+            if (frame.step == 3) {
+                stack.pop_back();
+                continue;
+            }
+            uint32_t face = frame.face;
+            int edge = (frame.first + frame.step++) % 3;
+            uint32_t other = faces[face].neighbor[edge];
+            if (faces[other].visit == stamp) continue;
+
+            if (distance(faces[other], eye) > tolerance) {
+                faces[other].visit = stamp;
+                visible.push_back(other);
+                int back = 0;
+                while (faces[other].neighbor[back] != face) back++;
+                stack.push_back({other, back + 1, 0}); // continue around from the edge we came in through
+            } else {
+                horizon.push_back({face, edge});
+            }
+        }
+    }
+
+    bool addPoint(uint32_t faceIndex) {
+        const vector<uint32_t> &outside = faces[faceIndex].outside;
+        uint32_t eye = outside[0];
+        float furthest = distance(faces[faceIndex], eye);
+        for (uint32_t point : outside) {
+            float d = distance(faces[faceIndex], point);
+            if (d > furthest) {
+                furthest = d;
+                eye = point;
+            }
+        }
+
+        findHorizon(faceIndex, eye);
+
+        uint32_t firstNew = uint32_t(faces.size());
+        for (const HorizonEdge &edge : horizon) {
+            uint32_t a = faces[edge.face].v[edge.edge];
+            uint32_t b = faces[edge.face].v[(edge.edge + 1) % 3];
+            uint32_t across = faces[edge.face].neighbor[edge.edge];
+            uint32_t added = addFace(a, b, eye);
+            faces[added].neighbor[0] = across;
+
+            HullFace &other = faces[across];
+            int back = 0;
+            while (back < 3 && !(other.neighbor[back] == edge.face && other.v[back] == b)) back++;
+            if (back == 3) return false;
+            other.neighbor[back] = added;
+        }
+
+        // Stitch the new faces to each other. The horizon must be a single loop for this to work.
+        uint32_t count = uint32_t(horizon.size());
+        for (uint32_t c = 0; c < count; c++) {
+            HullFace &face = faces[firstNew + c];
+            HullFace &next = faces[firstNew + (c + 1) % count];
+            if (face.v[1] != next.v[0]) return false;
+            face.neighbor[1] = firstNew + (c + 1) % count;
+            next.neighbor[2] = firstNew + c;
+        }
+
+        for (uint32_t face : visible) {
+            faces[face].alive = false;
+            for (uint32_t point : faces[face].outside) {
+                if (point != eye) assign(point, firstNew);
+            }
+            vector<uint32_t>().swap(faces[face].outside);
+        }
+        return true;
+    }
+
+    bool build() {
+        if (!initSimplex()) return false;
+        // New faces are appended, so a single pass sees every face that still has points outside.
+        for (uint32_t f = 0; f < faces.size(); f++) {
+            if (!faces[f].alive || faces[f].outside.empty()) continue;
+            if (!addPoint(f)) return false;
+        }
+        return true;
+    }
+};
+
+bool quickHull(const vec3 *points, size_t count, PolytopeHull3D *hull) {
+    QuickHull builder(points, uint32_t(count));
+    if (!builder.build()) return false;
+
+    vector<uint32_t> remap(count, uint32_t(-1));
+    for (const HullFace &face : builder.faces) {
+        if (!face.alive) continue;
+        for (uint32_t v : face.v) remap[v] = 0;
+    }
+
+    hull->points.clear();
+    hull->faces.clear();
+    hull->normals.clear();
+    for (uint32_t c = 0; c < count; c++) {
+        if (remap[c] == uint32_t(-1)) continue;
+        remap[c] = uint32_t(hull->points.size());
+        hull->points.push_back(points[c]);
+    }
+    for (const HullFace &face : builder.faces) {
+        if (!face.alive) continue;
+        hull->faces.push_back({remap[face.v[0]], remap[face.v[1]], remap[face.v[2]]});
+        hull->normals.push_back(face.normal);
+    }
+    return true;
+}
+
+bool quickHull(const vector<vec3> &points, PolytopeHull3D *hull) {
+    return quickHull(points.data(), points.size(), hull);
+}
+
+bool parallelQuickHull(const vector<vec3> &points, PolytopeHull3D *hull) {
+    size_t threads = std::max(1u, thread::hardware_concurrency());
+    threads = std::min(threads, points.size() / kMinPointsPerThread);
+    if (threads <= 1) return quickHull(points, hull);
+
+    // Every vertex of the hull is a vertex of the hull of its part, so hulling the parts first loses nothing.
+    vector<vector<vec3>> parts(threads);
+    vector<thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&points, &parts, t, threads]() {
+            const vec3 *begin = points.data() + points.size() * t / threads;
+            const vec3 *end = points.data() + points.size() * (t + 1) / threads;
+            PolytopeHull3D partial;
+            if (quickHull(begin, end - begin, &partial)) {
+                parts[t].swap(partial.points);
+            } else {
+                parts[t].assign(begin, end); // flat, so keep it whole
+            }
+        });
+    }
+    for (thread &worker : workers) worker.join();
+
+    // The parts are in input order, so the merged hull is too.
+    vector<vec3> merged;
+    for (const vector<vec3> &part : parts) merged.insert(merged.end(), part.begin(), part.end());
+    return quickHull(merged, hull);
+}
@@ -0,0 +1,20 @@
+//
+// Convex hulls of point sets, by quickhull.
+//
+
+#ifndef MINKOWSKIHULL3D_QUICKHULL3D_H
+#define MINKOWSKIHULL3D_QUICKHULL3D_H
+
+#include "hull3D.h"
+
+// Computes the convex hull of points. The hull's points are the hull vertices, in the order they appear in the input,
+// and its faces are triangles. Points closer to the hull than float precision allows to resolve are dropped.
+// Returns false if the points are flat, since the hull has no volume then.
+bool quickHull(const std::vector<glm::vec3> &points, PolytopeHull3D *hull);
+bool quickHull(const glm::vec3 *points, size_t count, PolytopeHull3D *hull);
+
+// Same as quickHull, but splits large point sets across all cores. Each part is hulled on its own thread, and then the
+// union of their vertices is hulled again.
+bool parallelQuickHull(const std::vector<glm::vec3> &points, PolytopeHull3D *hull);
+
+#endif //MINKOWSKIHULL3D_QUICKHULL3D_H
@@ -0,0 +1,205 @@
+//
+// Many posed colliders, with an incremental sweep and prune broadphase finding the pairs worth a narrowphase query.
+//
+
+#include <algorithm>
+
+#include "scene3D.h"
+
+using namespace std;
+using namespace glm;
+
+// Updates adding at least this fraction of the objects sort and sweep from scratch. Sorting new objects in from the end
+// of each axis costs a swap for every endpoint they pass, so it's only worth it for a few.
+static const size_t kRebuildFraction = 8;
+
+uint32_t Scene3D::add(const string &name, Collider3D *shape, const mat3 &rotation, vec3 position) {
+    uint32_t id = uint32_t(entries.size());
+    entries.emplace_back();
+    SceneObject3D &object = entries.back();
+    object.name = name;
+    object.posed.inner = shape;
+    object.posed.rotation = rotation;
+    object.posed.position = position;
+    computeBox(id);
+    names.emplace(name, id);
+    return id;
+}
+
+void Scene3D::setPose(uint32_t id, const mat3 &rotation, vec3 position) {
+    SceneObject3D &object = entries[id];
+    object.posed.rotation = rotation;
+    object.posed.position = position;
+    computeBox(id);
+    // Objects not sorted in yet pick up their new box when they are.
+    if (id < sorted) moved.push_back(id);
+}
+
+int Scene3D::find(const string &name) const {
+    auto found = names.find(name);
+    return found == names.end() ? -1 : int(found->second);
+}
+
+SubCollider3D Scene3D::difference(ScenePair3D pair) {
+    SubCollider3D sub;
+    sub.a = &entries[pair.a].posed;
+    sub.b = &entries[pair.b].posed;
+    return sub;
+}
+
+void Scene3D::computeBox(uint32_t id) {
+    SceneObject3D &object = entries[id];
+    for (int axis = 0; axis < 3; axis++) {
+        vec3 direction = vec3(0);
+        direction[axis] = 1;
+        object.upper[axis] = object.posed.findSupport(direction)[axis];
+        object.lower[axis] = object.posed.findSupport(-direction)[axis];
+    }
+    current.boxesUpdated++;
+}
+
+bool Scene3D::overlaps(uint32_t a, uint32_t b) const {
+    for (int axis = 0; axis < 3; axis++) {
+        const vector<uint32_t> &where = positions[axis];
+        if (where[2 * a] > where[2 * b + 1] || where[2 * b] > where[2 * a + 1]) return false;
+    }
+    return true;
+}
+
+void Scene3D::addPair(uint32_t a, uint32_t b) {
+    if (a > b) swap(a, b);
+    if (pairSet.insert(ScenePair3D{a, b}.key()).second) {
+        current.pairsAdded++;
+        pairListValid = false;
+    }
+}
+
+void Scene3D::removePair(uint32_t a, uint32_t b) {
+    if (a > b) swap(a, b);
+    if (pairSet.erase(ScenePair3D{a, b}.key())) {
+        current.pairsRemoved++;
+        pairListValid = false;
+    }
+}
+
+void Scene3D::update(BroadphaseStats *stats) {
+    size_t added = entries.size() - sorted;
+    if (added > 0 && added * kRebuildFraction >= entries.size()) {
+        rebuild();
+    } else {
+        for (uint32_t id : moved) {
+            for (int axis = 0; axis < 3; axis++) {
+                axes[axis][positions[axis][2 * id]].value = entries[id].lower[axis];
+                axes[axis][positions[axis][2 * id + 1]].value = entries[id].upper[axis];
+            }
+        }
+        // New objects start after everything else, where they overlap nothing, and are sorted in from there.
+        for (uint32_t id = uint32_t(sorted); id < entries.size(); id++) {
+            for (int axis = 0; axis < 3; axis++) {
+                positions[axis].push_back(uint32_t(axes[axis].size()));
+                axes[axis].push_back({entries[id].lower[axis], 2 * id});
+                positions[axis].push_back(uint32_t(axes[axis].size()));
+                axes[axis].push_back({entries[id].upper[axis], 2 * id + 1});
+            }
+        }
+        sorted = entries.size();
+        // Overlap tests during a sort see the axes after it in their old order. That's still right in the end: the
+        // last swap that changes whether a pair overlaps sees every other axis as it ends up.
+        for (int axis = 0; axis < 3; axis++) sortAxis(axis);
+    }
+    moved.clear();
+    if (stats) *stats = current;
+    current = BroadphaseStats();
+}
+
+void Scene3D::sortAxis(int axis) {
+    vector<Endpoint> &points = axes[axis];
+    vector<uint32_t> &where = positions[axis];
+    for (size_t c = 1; c < points.size(); c++) {
+        Endpoint moving = points[c];
+        size_t d = c;
+        while (d > 0 && moving.value < points[d - 1].value) {
+            Endpoint passed = points[d - 1];
+            points[d] = passed;
+            where[passed.handle] = uint32_t(d);
+            d--;
+            where[moving.handle] = uint32_t(d);
+            current.swaps++;
+
+            // A lower endpoint passing an upper one starts an overlap on this axis, and the reverse ends one.
+            bool movingUpper = moving.handle & 1, passedUpper = passed.handle & 1;
+            if (movingUpper == passedUpper) continue;
+            uint32_t a = moving.handle >> 1, b = passed.handle >> 1;
+            if (passedUpper) {
+                if (overlaps(a, b)) addPair(a, b);
+            } else {
+                removePair(a, b);
+            }
+        }
+        points[d] = moving;
+    }
+}
+
+void Scene3D::rebuild() {
+    current.rebuilt = true;
+    pairSet.clear();
+    pairListValid = false;
+    for (int axis = 0; axis < 3; axis++) {
+        vector<Endpoint> &points = axes[axis];
+        points.clear();
+        for (uint32_t id = 0; id < entries.size(); id++) {
+            points.push_back({entries[id].lower[axis], 2 * id});
+            points.push_back({entries[id].upper[axis], 2 * id + 1});
+        }
+        // Lower endpoints go first on ties, so boxes that touch when they are added overlap.
+        sort(points.begin(), points.end(), [](const Endpoint &p, const Endpoint &q) {
+            if (p.value != q.value) return p.value < q.value;
+            if ((p.handle & 1) != (q.handle & 1)) return (p.handle & 1) == 0;
+            return p.handle < q.handle;
+        });
+        positions[axis].resize(points.size());
+        for (size_t c = 0; c < points.size(); c++) positions[axis][points[c].handle] = uint32_t(c);
+    }
+    sorted = entries.size();
+
+    // Sweep the first axis, testing each object against the ones whose interval it starts inside. The active objects'
+    // positions on the other axes are kept packed beside them, so the inner loop reads memory in order.
+    struct Active {
+        uint32_t id;
+        uint32_t lower[2], upper[2];
+    };
+    vector<Active> active;
+    vector<uint32_t> slots(entries.size());
+    for (const Endpoint &point : axes[0]) {
+        uint32_t id = point.handle >> 1;
+        if (point.handle & 1) {
+            Active last = active.back();
+            active[slots[id]] = last;
+            slots[last.id] = slots[id];
+            active.pop_back();
+            continue;
+        }
+        Active entering = {id, {positions[1][2 * id], positions[2][2 * id]},
+                           {positions[1][2 * id + 1], positions[2][2 * id + 1]}};
+        // Few tests pass, so evaluating all four without branching is faster.
+        for (const Active &other : active) {
+            if ((entering.lower[0] < other.upper[0]) & (other.lower[0] < entering.upper[0]) &
+                (entering.lower[1] < other.upper[1]) & (other.lower[1] < entering.upper[1])) {
+                addPair(id, other.id);
+            }
+        }
+        slots[id] = uint32_t(active.size());
+        active.push_back(entering);
+    }
+}
+
+const vector<ScenePair3D> &Scene3D::pairs() {
+    if (!pairListValid) {
+        pairList.clear();
+        pairList.reserve(pairSet.size());
+        for (uint64_t key : pairSet) pairList.push_back({uint32_t(key >> 32), uint32_t(key)});
+        sort(pairList.begin(), pairList.end());
+        pairListValid = true;
+    }
+    return pairList;
+}
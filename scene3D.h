@@ -0,0 +1,91 @@
+//
+// Many posed colliders, with an incremental sweep and prune broadphase finding the pairs worth a narrowphase query.
+//
+
+#ifndef MINKOWSKIHULL3D_SCENE3D_H
+#define MINKOWSKIHULL3D_SCENE3D_H
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "hull3D.h"
+
+struct SceneObject3D {
+    std::string name;
+    TransformCollider3D posed; // the shape at its pose, which is what queries should use
+    glm::vec3 lower, upper; // the bounding box of posed, from six support queries
+};
+
+// Two objects whose bounding boxes overlap, with a < b.
+struct ScenePair3D {
+    uint32_t a, b;
+
+    bool operator<(const ScenePair3D &other) const { return a != other.a ? a < other.a : b < other.b; }
+    bool operator==(const ScenePair3D &other) const { return a == other.a && b == other.b; }
+    // A unique number for the pair, as a key for per pair state like ManifoldCache3D.
+    uint64_t key() const { return uint64_t(a) << 32 | b; }
+};
+
+struct BroadphaseStats {
+    size_t boxesUpdated = 0; // objects whose pose changed, each costing six support queries
+    size_t swaps = 0; // endpoint swaps sorting the three axes
+    size_t pairsAdded = 0, pairsRemoved = 0;
+    bool rebuilt = false; // sorted and swept from scratch, after adding many objects
+};
+
+// Sweep and prune over the bounding boxes. Each axis keeps the box endpoints sorted, and the overlapping pairs are kept
+// as a set. An update re-sorts the axes by insertion sort, which is nearly linear when objects moved a little, and
+// every swap of a lower endpoint with an upper one is a pair starting or stopping to overlap on that axis. So an update
+// costs the number of objects plus the number of swaps, however many pairs there are.
+// Boxes overlap when each one's lower endpoint is before the other's upper endpoint on every axis. Ties are broken by
+// the order the endpoints were sorted in, so boxes that only touch may or may not count.
+class Scene3D {
+public:
+    // Adds an object, which joins the pairs at the next update. Returns its id, which is its index in objects().
+    // Pointers to objects are invalidated by adding more.
+    uint32_t add(const std::string &name, Collider3D *shape, const glm::mat3 &rotation, glm::vec3 position);
+    // Moves an object, which updates its box now and its pairs at the next update.
+    void setPose(uint32_t id, const glm::mat3 &rotation, glm::vec3 position);
+
+    // Brings the pairs up to date with every add and setPose since the last update.
+    void update(BroadphaseStats *stats = nullptr);
+
+    // The overlapping pairs as of the last update, sorted.
+    const std::vector<ScenePair3D> &pairs();
+
+    const std::vector<SceneObject3D> &objects() const { return entries; }
+    SceneObject3D &object(uint32_t id) { return entries[id]; }
+    // The id of the object with name, or -1 if there is none. Names don't have to be unique; this finds the first.
+    int find(const std::string &name) const;
+
+    // The minkowski difference of a pair's posed shapes, for narrowphase queries or hulls. Invalidated by add.
+    SubCollider3D difference(ScenePair3D pair);
+
+private:
+    struct Endpoint {
+        float value;
+        uint32_t handle; // id * 2, plus 1 for the upper endpoint
+    };
+
+    void computeBox(uint32_t id);
+    bool overlaps(uint32_t a, uint32_t b) const;
+    void addPair(uint32_t a, uint32_t b);
+    void removePair(uint32_t a, uint32_t b);
+    void rebuild();
+    void sortAxis(int axis);
+
+    std::vector<SceneObject3D> entries;
+    std::unordered_map<std::string, uint32_t> names;
+    std::vector<Endpoint> axes[3];
+    std::vector<uint32_t> positions[3]; // where each endpoint is in its axis, by handle
+    std::vector<uint32_t> moved;
+    size_t sorted = 0; // objects already in the axes
+    std::unordered_set<uint64_t> pairSet;
+    std::vector<ScenePair3D> pairList;
+    bool pairListValid = true;
+    BroadphaseStats current;
+};
+
+#endif //MINKOWSKIHULL3D_SCENE3D_H
@@ -0,0 +1,74 @@
+//
+// Overlap queries on pairs that barely move between frames, answered from what the last query on each pair found.
+//
+
+#include <algorithm>
+
+#include "separationCache3D.h"
+
+using namespace std;
+using namespace glm;
+
+bool SeparationCache3D::intersect(Collider3D *a, Collider3D *b, SeparationCacheStats *stats) {
+    SeparationCacheStats ignored;
+    if (!stats) stats = &ignored;
+    stats->queries++;
+    Entry &entry = entries[PairKey{a, b}];
+    entry.touched = true;
+    GjkStats spent;
+    GjkSimplex simplex;
+
+    // Cached entries are checked by looking up their points again, which also starts the search on a miss.
+    if (entry.simplex.count > 0) {
+        if (!entry.overlap) {
+            vec3 axis = entry.simplex.directions[entry.simplex.count - 1];
+            gjkAddSupport(a, b, axis, simplex, &spent);
+            if (dot(simplex.points[0], axis) < 0) {
+                stats->hits++;
+                stats->supportCalls += spent.supportCalls;
+                stats->savedSupportCalls += std::max(0, entry.fullCalls - spent.supportCalls);
+                return false;
+            }
+        } else if (entry.simplex.count == 4) {
+            // Directions that find the same point again would leave a degenerate simplex to search on from.
+            for (int c = 0; c < 4; c++) {
+                gjkAddSupport(a, b, entry.simplex.directions[c], simplex, &spent);
+                for (int k = 0; k < simplex.count - 1; k++) {
+                    if (simplex.points[k] == simplex.points[simplex.count - 1]) {
+                        simplex.count--;
+                        break;
+                    }
+                }
+            }
+            GjkSimplex enclosing = simplex;
+            vec3 closest;
+            if (!gjkSolveSimplex(enclosing, &closest)) {
+                stats->hits++;
+                stats->supportCalls += spent.supportCalls;
+                stats->savedSupportCalls += std::max(0, entry.fullCalls - spent.supportCalls);
+                return true;
+            }
+        }
+    }
+
+    if (simplex.count == 0) {
+        gjkAddSupport(a, b, vec3(1, 0, 0), simplex, &spent);
+    }
+    entry.overlap = gjkIntersectFrom(a, b, &simplex, &spent);
+    entry.simplex = simplex;
+    entry.fullCalls = spent.supportCalls;
+    stats->supportCalls += spent.supportCalls;
+    return entry.overlap;
+}
+
+void SeparationCache3D::endFrame(SeparationCacheStats *stats) {
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.touched) {
+            it->second.touched = false;
+            ++it;
+        } else {
+            it = entries.erase(it);
+            if (stats) stats->evicted++;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+//
+// Overlap queries on pairs that barely move between frames, answered from what the last query on each pair found.
+//
+
+#ifndef MINKOWSKIHULL3D_SEPARATIONCACHE3D_H
+#define MINKOWSKIHULL3D_SEPARATIONCACHE3D_H
+
+#include <unordered_map>
+
+#include "gjk3D.h"
+
+struct SeparationCacheStats {
+    size_t queries = 0;
+    size_t hits = 0; // answered by the cached axis or simplex alone
+    size_t evicted = 0;
+    size_t supportCalls = 0; // as counted by GjkStats, one per support of the pair
+    // Support calls the pair's last full query took, minus the ones spent, summed over hits. Misses search on from the
+    // cached points, so they usually save a little too, which isn't counted.
+    size_t savedSupportCalls = 0;
+};
+
+// Remembers, for each pair of colliders, what proved the answer of its last overlap query. For a separated pair that
+// is the separating direction, which still separates them after a small move if one support of the pair is still
+// short of the origin along it. For an overlapping pair it is the tetrahedron of supports that enclosed the origin,
+// which still does after a small move if the supports looked up again in the same four directions do.
+// Either check proves its answer, so hits agree with gjkIntersect, except on pairs within rounding of touching, which
+// it counts as overlapping. A miss runs gjkIntersectFrom, starting from the supports the check looked up.
+// Pairs are keyed by the identity of their colliders, in order, so the colliders must keep their addresses while
+// cached.
+class SeparationCache3D {
+public:
+    // Whether a and b overlap, like gjkIntersect.
+    bool intersect(Collider3D *a, Collider3D *b, SeparationCacheStats *stats = nullptr);
+    // Drops the pairs that weren't queried since the last call.
+    void endFrame(SeparationCacheStats *stats = nullptr);
+    size_t size() const { return entries.size(); }
+    void clear() { entries.clear(); }
+
+private:
+    struct PairKey {
+        Collider3D *a, *b;
+
+        bool operator==(const PairKey &other) const { return a == other.a && b == other.b; }
+    };
+
+    struct PairKeyHash {
+        size_t operator()(const PairKey &key) const {
+            return std::hash<Collider3D *>()(key.a) * 31 + std::hash<Collider3D *>()(key.b);
+        }
+    };
+
+    struct Entry {
+        GjkSimplex simplex; // as the last full query left it, empty for a new pair
+        bool overlap = false;
+        int fullCalls = 0; // support calls the last full query took
+        bool touched = false;
+    };
+
+    std::unordered_map<PairKey, Entry, PairKeyHash> entries;
+};
+
+#endif //MINKOWSKIHULL3D_SEPARATIONCACHE3D_H
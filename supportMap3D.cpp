@@ -0,0 +1,121 @@
+//
+// Support queries on static point hulls through a precomputed cube map over directions.
+//
+
+#include <algorithm>
+#include <cmath>
+
+#include "supportMap3D.h"
+#include "workerPool.h"
+
+using namespace std;
+using namespace glm;
+
+// Dot products are evaluated exactly like the scan evaluates them, so this file is built with -ffp-contract=off too.
+
+// How far cells reach past their edges, in face coordinates. Covers the rounding of the cell lookup.
+static const float kCellPadding = 1e-4f;
+// A point is dropped only if it loses by this much times the largest point distance from the origin. Covers the
+// rounding of the dot products, both here and in the scan.
+static const float kDominanceSlack = 1e-5f;
+// Directions this short might underflow the dot products, so they go to the full scan.
+static const float kMinMappedDirection = 1e-18f;
+
+// The unit direction through face coordinates (u, v) of a cube face.
+// Face f looks along axis f / 2, positive if f is even, with u and v on the next two axes in order.
+static vec3 faceDirection(int face, float u, float v) {
+    int axis = face / 2;
+    vec3 dir;
+    dir[axis] = face % 2 == 0 ? 1.0f : -1.0f;
+    dir[(axis + 1) % 3] = u;
+    dir[(axis + 2) % 3] = v;
+    return normalize(dir);
+}
+
+void MappedPointsCollider3D::buildMap(int res) {
+    resolution = res;
+    size_t cellCount = 6 * size_t(res) * size_t(res);
+    cellStart.assign(1, 0);
+    candidates.clear();
+    if (count == 0 || res <= 0) {
+        resolution = 0;
+        return;
+    }
+
+    float maxNorm = 0;
+    for (size_t c = 0; c < count; c++) maxNorm = std::max(maxNorm, length(point(c)));
+    float slack = kDominanceSlack * maxNorm;
+
+    vector<vector<uint32_t>> cells(cellCount);
+    sharedWorkerPool().parallelFor(cellCount, [&](size_t cell) {
+        int face = int(cell / (res * res));
+        int i = int(cell / res % res), j = int(cell % res);
+        float u0 = -1 + 2.0f * i / res - kCellPadding, u1 = -1 + 2.0f * (i + 1) / res + kCellPadding;
+        float v0 = -1 + 2.0f * j / res - kCellPadding, v1 = -1 + 2.0f * (j + 1) / res + kCellPadding;
+        vec3 corners[4] = {faceDirection(face, u0, v0), faceDirection(face, u1, v0),
+                           faceDirection(face, u1, v1), faceDirection(face, u0, v1)};
+
+        // The supports at the corners and center are the points most likely to beat everything else in the cell.
+        size_t rivals[5];
+        for (int k = 0; k < 4; k++) rivals[k] = PointHullCollider3D::findSupportIndex(corners[k]);
+        rivals[4] = PointHullCollider3D::findSupportIndex(faceDirection(face, (u0 + u1) / 2, (v0 + v1) / 2));
+        float rivalDots[5][4];
+        for (int r = 0; r < 5; r++) {
+            for (int k = 0; k < 4; k++) rivalDots[r][k] = dot(point(rivals[r]), corners[k]);
+        }
+
+        // Dot products are linear in the direction, so losing at every corner of the cell means losing everywhere
+        // in it. Normalizing only scales them, so that holds for every direction through the cell.
+        vector<uint32_t> &list = cells[cell];
+        for (size_t c = 0; c < count; c++) {
+            vec3 pt = point(c);
+            float dots[4];
+            for (int k = 0; k < 4; k++) dots[k] = dot(pt, corners[k]);
+            bool dominated = false;
+            for (int r = 0; r < 5 && !dominated; r++) {
+                dominated = dots[0] < rivalDots[r][0] - slack && dots[1] < rivalDots[r][1] - slack &&
+                            dots[2] < rivalDots[r][2] - slack && dots[3] < rivalDots[r][3] - slack;
+            }
+            if (!dominated) list.push_back(uint32_t(c));
+        }
+    });
+
+    for (const vector<uint32_t> &list : cells) {
+        candidates.insert(candidates.end(), list.begin(), list.end());
+        cellStart.push_back(uint32_t(candidates.size()));
+    }
+}
+
+size_t MappedPointsCollider3D::mapBytes() const {
+    return (cellStart.size() + candidates.size()) * sizeof(uint32_t);
+}
+
+size_t MappedPointsCollider3D::findSupportIndex(vec3 direction) const {
+    vec3 mag = abs(direction);
+    int axis = mag.x >= mag.y && mag.x >= mag.z ? 0 : mag.y >= mag.z ? 1 : 2;
+    float major = mag[axis];
+    // Infinite or NaN coordinates would make the cell lookup convert NaN to int, so those go to the scan too.
+    bool finite = std::isfinite(direction.x) && std::isfinite(direction.y) && std::isfinite(direction.z);
+    if (resolution == 0 || !finite || !(major >= kMinMappedDirection)) {
+        return PointHullCollider3D::findSupportIndex(direction);
+    }
+
+    int face = axis * 2 + (direction[axis] < 0 ? 1 : 0);
+    float scale = 0.5f * resolution / major;
+    int i = std::min(resolution - 1, std::max(0, int((direction[(axis + 1) % 3] + major) * scale)));
+    int j = std::min(resolution - 1, std::max(0, int((direction[(axis + 2) % 3] + major) * scale)));
+    size_t cell = (size_t(face) * resolution + i) * resolution + j;
+
+    // Candidates are in index order, so keeping the first maximum breaks ties like the scan.
+    size_t best = 0;
+    float bestDot = -INFINITY;
+    for (uint32_t c = cellStart[cell], end = cellStart[cell + 1]; c < end; c++) {
+        uint32_t index = candidates[c];
+        float d = direction.x * xs[index] + direction.y * ys[index] + direction.z * zs[index];
+        if (d > bestDot) {
+            bestDot = d;
+            best = index;
+        }
+    }
+    return best;
+}
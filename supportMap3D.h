@@ -0,0 +1,31 @@
+//
+// Support queries on static point hulls through a precomputed cube map over directions.
+//
+
+#ifndef MINKOWSKIHULL3D_SUPPORTMAP3D_H
+#define MINKOWSKIHULL3D_SUPPORTMAP3D_H
+
+#include "hull3D.h"
+
+// Each face of a cube around the origin is split into resolution x resolution cells, and every cell lists the points
+// that could be the support for some direction through it. A query finds its cell and only scans that list.
+// Points are dropped from a cell only if another point beats them by a rounding margin across the whole cell, and
+// cells are padded slightly past their edges, so the result is exactly the point PointHullCollider3D would return.
+// Call buildMap after setPoints, and again whenever the points change.
+struct MappedPointsCollider3D : public PointHullCollider3D {
+    int resolution = 0;
+    std::vector<uint32_t> cellStart; // offsets of each cell's list in candidates, with one extra at the end
+    std::vector<uint32_t> candidates; // point indices, increasing within each cell
+
+    void buildMap(int resolution);
+    size_t mapBytes() const;
+
+    size_t findSupportIndex(glm::vec3 direction) const;
+
+    glm::vec3 findSupport(glm::vec3 direction) override {
+        if (count == 0) return glm::vec3(0);
+        return point(findSupportIndex(direction));
+    }
+};
+
+#endif //MINKOWSKIHULL3D_SUPPORTMAP3D_H
@@ -0,0 +1,240 @@
+//
+// Support scans over points stored as separate coordinate arrays.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "supportScan3D.h"
+#include "workerPool.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SCAN_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace glm;
+
+// The dot product is always evaluated as (x + y) + z with separate multiplies, like glm::dot.
+// This file is built with -ffp-contract=off, since AVX-512 implies FMA and fusing would change the rounding.
+
+// Each lane keeps the first maximum it has seen, and lanes see increasing indices,
+// so the first maximum overall is the best lane value with the lowest index.
+static size_t reduceLanes(const float *dots, const uint32_t *indices, int lanes, float *bestDot) {
+    size_t best = indices[0];
+    *bestDot = dots[0];
+    for (int c = 1; c < lanes; c++) {
+        if (dots[c] > *bestDot || (dots[c] == *bestDot && indices[c] < best)) {
+            *bestDot = dots[c];
+            best = indices[c];
+        }
+    }
+    return best;
+}
+
+static size_t scanTail(const float *xs, const float *ys, const float *zs, size_t begin, size_t end, vec3 dir,
+                       size_t best, float bestDot) {
+    for (size_t c = begin; c < end; c++) {
+        float d = dir.x * xs[c] + dir.y * ys[c] + dir.z * zs[c];
+        if (d > bestDot) {
+            bestDot = d;
+            best = c;
+        }
+    }
+    return best;
+}
+
+static size_t scanScalar(const float *xs, const float *ys, const float *zs, size_t count, vec3 dir) {
+    return scanTail(xs, ys, zs, 0, count, dir, 0, -numeric_limits<float>::infinity());
+}
+
+#ifdef SCAN_X86
+
+__attribute__((target("sse4.1")))
+static size_t scanSSE4(const float *xs, const float *ys, const float *zs, size_t count, vec3 dir) {
+    __m128 dx = _mm_set1_ps(dir.x), dy = _mm_set1_ps(dir.y), dz = _mm_set1_ps(dir.z);
+    __m128 bestDots = _mm_set1_ps(-numeric_limits<float>::infinity());
+    __m128 bestIndices = _mm_castsi128_ps(_mm_setzero_si128());
+    __m128i indices = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i step = _mm_set1_epi32(4);
+
+    size_t end = count & ~size_t(3);
+    for (size_t c = 0; c < end; c += 4) {
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(xs + c)), _mm_mul_ps(dy, _mm_loadu_ps(ys + c))),
+                              _mm_mul_ps(dz, _mm_loadu_ps(zs + c)));
+        __m128 greater = _mm_cmpgt_ps(d, bestDots);
+        bestDots = _mm_blendv_ps(bestDots, d, greater);
+        bestIndices = _mm_blendv_ps(bestIndices, _mm_castsi128_ps(indices), greater);
+        indices = _mm_add_epi32(indices, step);
+    }
+
+    float dots[4];
+    uint32_t lanes[4];
+    _mm_storeu_ps(dots, bestDots);
+    _mm_storeu_si128((__m128i *) lanes, _mm_castps_si128(bestIndices));
+    float bestDot;
+    size_t best = reduceLanes(dots, lanes, 4, &bestDot);
+    return scanTail(xs, ys, zs, end, count, dir, best, bestDot);
+}
+
+__attribute__((target("avx2")))
+static size_t scanAVX2(const float *xs, const float *ys, const float *zs, size_t count, vec3 dir) {
+    __m256 dx = _mm256_set1_ps(dir.x), dy = _mm256_set1_ps(dir.y), dz = _mm256_set1_ps(dir.z);
+    __m256 bestDots = _mm256_set1_ps(-numeric_limits<float>::infinity());
+    __m256i bestIndices = _mm256_setzero_si256();
+    __m256i indices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i step = _mm256_set1_epi32(8);
+
+    size_t end = count & ~size_t(7);
+    for (size_t c = 0; c < end; c += 8) {
+        __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, _mm256_loadu_ps(xs + c)),
+                                               _mm256_mul_ps(dy, _mm256_loadu_ps(ys + c))),
+                                 _mm256_mul_ps(dz, _mm256_loadu_ps(zs + c)));
+        __m256 greater = _mm256_cmp_ps(d, bestDots, _CMP_GT_OQ);
+        bestDots = _mm256_blendv_ps(bestDots, d, greater);
+        bestIndices = _mm256_blendv_epi8(bestIndices, indices, _mm256_castps_si256(greater));
+        indices = _mm256_add_epi32(indices, step);
+    }
+
+    float dots[8];
+    uint32_t lanes[8];
+    _mm256_storeu_ps(dots, bestDots);
+    _mm256_storeu_si256((__m256i *) lanes, bestIndices);
+    float bestDot;
+    size_t best = reduceLanes(dots, lanes, 8, &bestDot);
+    return scanTail(xs, ys, zs, end, count, dir, best, bestDot);
+}
+
+__attribute__((target("avx512f")))
+static size_t scanAVX512(const float *xs, const float *ys, const float *zs, size_t count, vec3 dir) {
+    __m512 dx = _mm512_set1_ps(dir.x), dy = _mm512_set1_ps(dir.y), dz = _mm512_set1_ps(dir.z);
+    __m512 bestDots = _mm512_set1_ps(-numeric_limits<float>::infinity());
+    __m512i bestIndices = _mm512_setzero_si512();
+    __m512i indices = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m512i step = _mm512_set1_epi32(16);
+
+    size_t end = count & ~size_t(15);
+    for (size_t c = 0; c < end; c += 16) {
+        __m512 d = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(dx, _mm512_loadu_ps(xs + c)),
+                                               _mm512_mul_ps(dy, _mm512_loadu_ps(ys + c))),
+                                 _mm512_mul_ps(dz, _mm512_loadu_ps(zs + c)));
+        __mmask16 greater = _mm512_cmp_ps_mask(d, bestDots, _CMP_GT_OQ);
+        bestDots = _mm512_mask_mov_ps(bestDots, greater, d);
+        bestIndices = _mm512_mask_mov_epi32(bestIndices, greater, indices);
+        indices = _mm512_add_epi32(indices, step);
+    }
+
+    float dots[16];
+    uint32_t lanes[16];
+    _mm512_storeu_ps(dots, bestDots);
+    _mm512_storeu_si512(lanes, bestIndices);
+    float bestDot;
+    size_t best = reduceLanes(dots, lanes, 16, &bestDot);
+    return scanTail(xs, ys, zs, end, count, dir, best, bestDot);
+}
+
+#endif
+
+typedef size_t (*ScanFunction)(const float *, const float *, const float *, size_t, vec3);
+
+static ScanFunction scanFunction(ScanKernel kernel) {
+    switch (kernel) {
+#ifdef SCAN_X86
+        case SCAN_SSE4: return scanSSE4;
+        case SCAN_AVX2: return scanAVX2;
+        case SCAN_AVX512: return scanAVX512;
+#endif
+        default: return scanScalar;
+    }
+}
+
+bool scanKernelSupported(ScanKernel kernel) {
+#ifdef SCAN_X86
+    switch (kernel) {
+        case SCAN_SCALAR: return true;
+        case SCAN_SSE4: return __builtin_cpu_supports("sse4.1");
+        case SCAN_AVX2: return __builtin_cpu_supports("avx2");
+        case SCAN_AVX512: return __builtin_cpu_supports("avx512f");
+        default: return false;
+    }
+#else
+    return kernel == SCAN_SCALAR;
+#endif
+}
+
+const char *scanKernelName(ScanKernel kernel) {
+    switch (kernel) {
+        case SCAN_SCALAR: return "scalar";
+        case SCAN_SSE4: return "sse4";
+        case SCAN_AVX2: return "avx2";
+        case SCAN_AVX512: return "avx512";
+        default: return "unknown";
+    }
+}
+
+ScanKernel bestScanKernel() {
+    static ScanKernel best = [] {
+        ScanKernel kernel = SCAN_SCALAR;
+        for (int c = SCAN_SCALAR; c < NUM_SCAN_KERNELS; c++) {
+            if (scanKernelSupported(ScanKernel(c))) kernel = ScanKernel(c);
+        }
+        return kernel;
+    }();
+    return best;
+}
+
+size_t supportScan(const float *xs, const float *ys, const float *zs, size_t count, vec3 direction) {
+    static ScanFunction best = scanFunction(bestScanKernel());
+    return best(xs, ys, zs, count, direction);
+}
+
+size_t supportScan(const float *xs, const float *ys, const float *zs, size_t count, vec3 direction, ScanKernel kernel) {
+    return scanFunction(kernel)(xs, ys, zs, count, direction);
+}
+
+size_t supportScan(const float *xs, const float *ys, const float *zs, size_t count, vec3 direction, float *bestDot) {
+    size_t best = supportScan(xs, ys, zs, count, direction);
+    *bestDot = count == 0 ? -numeric_limits<float>::infinity() :
+               direction.x * xs[best] + direction.y * ys[best] + direction.z * zs[best];
+    return best;
+}
+
+size_t parallelSupportScan(const float *xs, const float *ys, const float *zs, size_t count, vec3 direction) {
+    return parallelSupportScan(xs, ys, zs, count, direction, sharedWorkerPool());
+}
+
+size_t parallelSupportScan(const float *xs, const float *ys, const float *zs, size_t count, vec3 direction,
+                           WorkerPool &pool) {
+    size_t blocks = pool.threadCount();
+    size_t blockSize = (count / blocks + kSupportScanLanes - 1) / kSupportScanLanes * kSupportScanLanes;
+    if (blocks <= 1 || blockSize == 0) return supportScan(xs, ys, zs, count, direction);
+    blocks = (count + blockSize - 1) / blockSize;
+
+    vector<size_t> bests(blocks);
+    vector<float> bestDots(blocks);
+    pool.parallelFor(blocks, [&](size_t block) {
+        size_t begin = block * blockSize;
+        size_t size = std::min(blockSize, count - begin);
+        bests[block] = begin + supportScan(xs + begin, ys + begin, zs + begin, size, direction, &bestDots[block]);
+    });
+
+    // Strictly greater, so the earliest block wins a tie, like it would in a serial scan.
+    size_t best = bests[0];
+    float bestDot = bestDots[0];
+    for (size_t block = 1; block < blocks; block++) {
+        if (bestDots[block] > bestDot) {
+            bestDot = bestDots[block];
+            best = bests[block];
+        }
+    }
+    return best;
+}
+
+size_t pointsSupportScan(const float *xs, const float *ys, const float *zs, size_t count, vec3 direction,
+                         bool parallel) {
+    if (parallel && count >= kMinParallelScanPoints) return parallelSupportScan(xs, ys, zs, count, direction);
+    return supportScan(xs, ys, zs, count, direction);
+}
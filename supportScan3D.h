@@ -0,0 +1,51 @@
+//
+// Support scans over points stored as separate coordinate arrays.
+//
+
+#ifndef MINKOWSKIHULL3D_SUPPORTSCAN3D_H
+#define MINKOWSKIHULL3D_SUPPORTSCAN3D_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// The widest kernel handles this many points at a time. Arrays padded to a multiple of it never need a scalar tail.
+const size_t kSupportScanLanes = 16;
+
+enum ScanKernel {
+    SCAN_SCALAR,
+    SCAN_SSE4,
+    SCAN_AVX2,
+    SCAN_AVX512,
+    NUM_SCAN_KERNELS
+};
+
+// The fastest kernel this CPU supports. Detected once, on first use.
+ScanKernel bestScanKernel();
+bool scanKernelSupported(ScanKernel kernel);
+const char *scanKernelName(ScanKernel kernel);
+
+// Returns the index of the first point with the greatest dot product with direction, or 0 if there is none.
+// Every kernel computes the dot products the same way and breaks ties the same way, so they all agree exactly.
+size_t supportScan(const float *xs, const float *ys, const float *zs, size_t count, glm::vec3 direction);
+size_t supportScan(const float *xs, const float *ys, const float *zs, size_t count, glm::vec3 direction, ScanKernel kernel);
+
+// Same as supportScan, and also returns the dot product of the best point, rounded exactly like the scan rounds it.
+size_t supportScan(const float *xs, const float *ys, const float *zs, size_t count, glm::vec3 direction, float *bestDot);
+
+class WorkerPool;
+
+// Scans of at least this many points are worth splitting across threads.
+const size_t kMinParallelScanPoints = 1 << 18;
+
+// Same result as supportScan, but splits the points into one block per thread of the pool, or of sharedWorkerPool().
+// Blocks are reduced in order with the same tie breaking, so the result doesn't depend on the number of threads.
+size_t parallelSupportScan(const float *xs, const float *ys, const float *zs, size_t count, glm::vec3 direction);
+size_t parallelSupportScan(const float *xs, const float *ys, const float *zs, size_t count, glm::vec3 direction,
+                           WorkerPool &pool);
+
+// The scan the point colliders use: parallelSupportScan if parallel is set and there are enough points, else
+// supportScan.
+size_t pointsSupportScan(const float *xs, const float *ys, const float *zs, size_t count, glm::vec3 direction,
+                         bool parallel);
+
+#endif //MINKOWSKIHULL3D_SUPPORTSCAN3D_H
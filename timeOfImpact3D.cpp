@@ -0,0 +1,94 @@
+//
+// Time of impact of moving colliders by conservative advancement, so fast objects can't pass through each other
+// between steps.
+//
+
+#include <algorithm>
+#include <cmath>
+
+#include "timeOfImpact3D.h"
+
+using namespace std;
+using namespace glm;
+
+mat3 Motion3D::rotationAt(float t) const {
+    return t == 0 ? rotation : axisAngleRotation(t * angular) * rotation;
+}
+
+// Directions probed around the spin axis to bound a shape's distance from it.
+static const int kAxialProbes = 8;
+
+// No point of shape, posed by rotation, is further than this from the axis through its origin. Every point is within
+// pi / kAxialProbes of one of the probes around the axis, so its distance times the cosine of that is at most the
+// probe's support value. Spinning about the axis doesn't change the distance, so the bound holds for the whole step.
+static float axialRadius(Collider3D *shape, const mat3 &rotation, vec3 axis, int *supportCalls) {
+    vec3 local = normalize(transpose(rotation) * axis);
+    vec3 u = normalize(cross(local, std::abs(local.x) < 0.5f ? vec3(1, 0, 0) : vec3(0, 1, 0)));
+    vec3 v = cross(local, u);
+    float reach = 0;
+    for (int k = 0; k < kAxialProbes; k++) {
+        float angle = float(k) * 6.28318531f / kAxialProbes;
+        vec3 direction = std::cos(angle) * u + std::sin(angle) * v;
+        reach = std::max(reach, dot(shape->findSupport(direction), direction));
+    }
+    *supportCalls += kAxialProbes;
+    return reach / std::cos(3.14159265f / kAxialProbes);
+}
+
+bool timeOfImpact(Collider3D *a, const Motion3D &motionA, Collider3D *b, const Motion3D &motionB,
+                  const ImpactSettings &settings, ImpactResult *result) {
+    *result = ImpactResult();
+    bool spinA = motionA.angular != vec3(0), spinB = motionB.angular != vec3(0);
+    float radiusA = spinA ? axialRadius(a, motionA.rotation, motionA.angular, &result->supportCalls) : 0;
+    float radiusB = spinB ? axialRadius(b, motionB.rotation, motionB.angular, &result->supportCalls) : 0;
+
+    TransformCollider3D posedA, posedB;
+    posedA.inner = a;
+    posedB.inner = b;
+    GjkSimplex simplex;
+    float t = 0;
+    while (true) {
+        posedA.rotation = motionA.rotationAt(t);
+        posedA.position = motionA.positionAt(t);
+        posedB.rotation = motionB.rotationAt(t);
+        posedB.position = motionB.positionAt(t);
+        DistanceResult distance;
+        bool apart = gjkDistance(&posedA, &posedB, &distance, &simplex);
+        result->distanceIterations += distance.iterations;
+        result->supportCalls += distance.supportCalls;
+        result->time = t;
+        if (!apart) {
+            // Advancing never closes the whole distance, so only rounding can get here after the start.
+            result->status = t == 0 ? IMPACT_OVERLAP : IMPACT_HIT;
+            return true;
+        }
+        result->normal = normalize(distance.witnessB - distance.witnessA);
+        result->witnessA = distance.witnessA;
+        result->witnessB = distance.witnessB;
+        if (distance.distance <= settings.tolerance) {
+            result->status = IMPACT_HIT;
+            return true;
+        }
+        if (result->iterations == settings.maxIterations) {
+            result->status = IMPACT_UNCONVERGED;
+            return true;
+        }
+
+        // No point of either shape closes the gap along the normal faster than this. Linear motion is exact, since the
+        // distance along a line through the space of relative positions is convex. A point at r from the spin axis
+        // moves along the normal at most |normal x angular| r, which is small when the shape spins about the normal.
+        float closing = dot(motionA.linear - motionB.linear, result->normal) +
+                        length(cross(result->normal, motionA.angular)) * radiusA +
+                        length(cross(result->normal, motionB.angular)) * radiusB;
+        if (closing <= 0) break;
+        // Aim for half the tolerance, so a step that closes the gap exactly lands inside it.
+        t += (distance.distance - 0.5f * settings.tolerance) / closing;
+        if (t > 1) break;
+        result->iterations++;
+    }
+
+    result->status = IMPACT_NONE;
+    result->time = 1;
+    result->normal = result->witnessA = result->witnessB = vec3(0);
+    return false;
+}
@@ -0,0 +1,55 @@
+//
+// Time of impact of moving colliders by conservative advancement, so fast objects can't pass through each other
+// between steps.
+//
+
+#ifndef MINKOWSKIHULL3D_TIMEOFIMPACT3D_H
+#define MINKOWSKIHULL3D_TIMEOFIMPACT3D_H
+
+#include "gjk3D.h"
+
+// How a collider moves over a step. Its pose at time t in [0, 1] is the rotation by t * angular, applied after the
+// starting rotation, then the translation to position + t * linear. Rotations are about the collider's own origin.
+struct Motion3D {
+    glm::mat3 rotation = glm::mat3(1);
+    glm::vec3 position = glm::vec3(0);
+    glm::vec3 linear = glm::vec3(0); // the translation over the whole step
+    glm::vec3 angular = glm::vec3(0); // the rotation over the whole step, as an axis scaled by the angle in radians
+
+    glm::mat3 rotationAt(float t) const;
+    glm::vec3 positionAt(float t) const { return position + t * linear; }
+};
+
+struct ImpactSettings {
+    // Contact is when the shapes are this close. At the time reported they are within it, but still apart.
+    float tolerance = 1e-3f;
+    int maxIterations = 64; // advancements, each a distance query
+};
+
+enum ImpactStatus {
+    IMPACT_NONE, // the shapes stay apart for the whole step
+    IMPACT_HIT, // they come within the tolerance at time
+    IMPACT_OVERLAP, // they overlap at the start, so time is 0
+    IMPACT_UNCONVERGED, // the iterations ran out; they are still apart at time, which is a safe step to take
+};
+
+struct ImpactResult {
+    ImpactStatus status = IMPACT_NONE;
+    float time = 1; // the fraction of the step before contact, or 1 if there is none
+    glm::vec3 normal = glm::vec3(0); // the unit direction from a to b at time, unless they overlap
+    glm::vec3 witnessA = glm::vec3(0), witnessB = glm::vec3(0); // the closest points at time, unless they overlap
+    int iterations = 0; // advancements
+    int distanceIterations = 0; // GJK iterations over all the distance queries
+    int supportCalls = 0;
+};
+
+// Advances the shapes together as far as they can safely go: the distance between them, over a bound on how fast any
+// of their points can close it along the line between the closest points. Linear motion alone is bounded exactly, so
+// that usually takes two or three distance queries. Rotation adds, for each shape, the part of its spin that turns
+// points along the normal, times its distance from the spin axis, found from eight support queries. Each distance query
+// is warm started from the one before.
+// Returns whether the shapes touch during the step, which includes IMPACT_UNCONVERGED.
+bool timeOfImpact(Collider3D *a, const Motion3D &motionA, Collider3D *b, const Motion3D &motionB,
+                  const ImpactSettings &settings, ImpactResult *result);
+
+#endif //MINKOWSKIHULL3D_TIMEOFIMPACT3D_H
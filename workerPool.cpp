@@ -0,0 +1,76 @@
+//
+// A persistent pool of threads for parallel loops.
+//
+
+#include <algorithm>
+
+#include "workerPool.h"
+
+using namespace std;
+
+WorkerPool::WorkerPool(unsigned workerCount) : nextTask(0) {
+    for (unsigned c = 0; c < workerCount; c++) {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (thread &worker : workers) worker.join();
+}
+
+void WorkerPool::runTasks() {
+    for (size_t index = nextTask++; index < taskCount; index = nextTask++) {
+        (*task)(index);
+    }
+}
+
+void WorkerPool::workerLoop() {
+    unsigned seen = 0;
+    while (true) {
+        {
+            unique_lock<mutex> guard(lock);
+            wake.wait(guard, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+
+        runTasks();
+
+        lock_guard<mutex> guard(lock);
+        if (--running == 0) finished.notify_one();
+    }
+}
+
+void WorkerPool::parallelFor(size_t count, const function<void(size_t)> &run) {
+    unique_lock<mutex> owner(busy, try_to_lock);
+    if (!owner.owns_lock() || workers.empty() || count <= 1) {
+        for (size_t c = 0; c < count; c++) run(c);
+        return;
+    }
+
+    {
+        lock_guard<mutex> guard(lock);
+        task = &run;
+        taskCount = count;
+        nextTask = 0;
+        running = workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    runTasks();
+
+    unique_lock<mutex> guard(lock);
+    finished.wait(guard, [&] { return running == 0; });
+    task = nullptr;
+}
+
+WorkerPool &sharedWorkerPool() {
+    static WorkerPool pool(max(1u, thread::hardware_concurrency()) - 1);
+    return pool;
+}
@@ -0,0 +1,49 @@
+//
+// A persistent pool of threads for parallel loops.
+//
+
+#ifndef MINKOWSKIHULL3D_WORKERPOOL_H
+#define MINKOWSKIHULL3D_WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The calling thread takes part in every loop, so a pool with N workers runs N + 1 tasks at once.
+// Only one loop runs at a time. A loop started while another is running, including from inside one of its tasks,
+// runs on the calling thread alone instead of waiting, so nesting can't deadlock.
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned workers);
+    ~WorkerPool();
+
+    unsigned threadCount() const { return unsigned(workers.size()) + 1; }
+
+    // Calls task(i) for every i in [0, count), and returns once they have all finished.
+    void parallelFor(size_t count, const std::function<void(size_t)> &task);
+
+private:
+    void workerLoop();
+    void runTasks();
+
+    std::vector<std::thread> workers;
+    std::mutex busy; // held while a loop runs
+    std::mutex lock; // guards everything below
+    std::condition_variable wake;
+    std::condition_variable finished;
+    const std::function<void(size_t)> *task = nullptr;
+    size_t taskCount = 0;
+    std::atomic<size_t> nextTask;
+    size_t running = 0; // workers still inside the current loop
+    unsigned generation = 0;
+    bool stopping = false;
+};
+
+// A pool with a worker for every core but the calling one, started on first use.
+WorkerPool &sharedWorkerPool();
+
+#endif //MINKOWSKIHULL3D_WORKERPOOL_H